@@ -0,0 +1,84 @@
+#include "HidMock.h"
+#include "helpers/InputHelper.h"
+#include <mutex>
+
+static_assert(HID_TOUCH_MAX_TOUCHES == 1, "HidMock only stores a single touch");
+
+static std::mutex __stateMutex;
+static nn::hid::NpadBaseState __npadState = {};
+static nn::hid::KeyboardState __keyboardState = {};
+static nn::hid::MouseState __mouseState = {};
+static nn::hid::TouchScreenState<HID_TOUCH_MAX_TOUCHES> __touchState = {};
+static u64 __samplingNumber = 0;
+
+void HidMock::setNpadState(const nn::hid::NpadBaseState &state) {
+  std::lock_guard lock(__stateMutex);
+  __npadState = state;
+}
+
+void HidMock::setKeyboardState(const nn::hid::KeyboardState &state) {
+  std::lock_guard lock(__stateMutex);
+  __keyboardState = state;
+}
+
+void HidMock::setMouseState(const nn::hid::MouseState &state) {
+  std::lock_guard lock(__stateMutex);
+  __mouseState = state;
+}
+
+void HidMock::setTouchState(const nn::hid::TouchScreenState<1> &state) {
+  std::lock_guard lock(__stateMutex);
+  __touchState = state;
+}
+
+namespace nn::hid {
+
+  void InitializeNpad() {}
+
+  void InitializeKeyboard() {}
+
+  void InitializeMouse() {}
+
+  NpadStyleSet GetNpadStyleSet(const uint &) {
+    NpadStyleSet styleSet = {};
+    styleSet.field[0] = 1u << (u32) NpadStyleTag::NpadStyleFullKey;
+    return styleSet;
+  }
+
+  static void getNpadState(NpadBaseState *state) {
+    std::lock_guard lock(__stateMutex);
+    *state = __npadState;
+    state->mSamplingNumber = ++__samplingNumber;
+  }
+
+  void GetNpadState(NpadFullKeyState *state, const uint &) {
+    getNpadState(state);
+  }
+
+  void GetNpadState(NpadHandheldState *state, const uint &) {
+    getNpadState(state);
+  }
+
+  void GetNpadState(NpadJoyDualState *state, const uint &) {
+    getNpadState(state);
+  }
+
+  void GetKeyboardState(KeyboardState *state) {
+    std::lock_guard lock(__stateMutex);
+    *state = __keyboardState;
+    state->samplingNumber = ++__samplingNumber;
+  }
+
+  void GetMouseState(MouseState *state) {
+    std::lock_guard lock(__stateMutex);
+    *state = __mouseState;
+    state->samplingNumber = ++__samplingNumber;
+  }
+
+  template <>
+  void GetTouchScreenState<HID_TOUCH_MAX_TOUCHES>(TouchScreenState<HID_TOUCH_MAX_TOUCHES> *state) {
+    std::lock_guard lock(__stateMutex);
+    *state = __touchState;
+    state->samplingNumber = ++__samplingNumber;
+  }
+}
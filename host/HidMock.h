@@ -0,0 +1,17 @@
+#pragma once
+
+#include "nn/hid.h"
+
+// input seen by InputHelper on host builds. every state stays until it gets replaced, and is reported with a new
+// sampling number on each read. the pad is always reported as a full key controller.
+namespace HidMock {
+
+  void setNpadState(const nn::hid::NpadBaseState &state);
+
+  void setKeyboardState(const nn::hid::KeyboardState &state);
+
+  void setMouseState(const nn::hid::MouseState &state);
+
+  // NumTouches matches HID_TOUCH_MAX_TOUCHES
+  void setTouchState(const nn::hid::TouchScreenState<1> &state);
+}
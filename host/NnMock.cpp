@@ -0,0 +1,515 @@
+#include "NnMock.h"
+#include "glslc/glslc.h"
+#include "nn/diag.h"
+#include "nn/fs.h"
+#include "nn/os.h"
+#include "nn/os/os_tick.hpp"
+#include "nn/ro.h"
+#include "nn/util.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+static constexpr Result ResultMockFailure = 1;
+static constexpr Result ResultPathNotFound = 0x202;
+
+// host state of nn::os objects, looked up by the address of the game-side object
+template <typename T>
+struct MockObjects {
+  static T &get(const void *object) {
+    std::lock_guard lock(mutex);
+    auto &mock = objects[object];
+    if (!mock) {
+      mock = std::make_unique<T>();
+    }
+    return *mock;
+  }
+
+  static void release(const void *object) {
+    std::lock_guard lock(mutex);
+    objects.erase(object);
+  }
+
+  static inline std::mutex mutex;
+  static inline std::unordered_map<const void *, std::unique_ptr<T>> objects;
+};
+
+struct MockEvent {
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool isSignaled;
+  bool isAutoClear;
+};
+
+struct MockMutex {
+  std::recursive_mutex mutex;
+};
+
+struct MockMessageQueue {
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<u64> messages;
+  size_t capacity;
+};
+
+struct MockThread {
+  void (*func)(void *);
+  void *arg;
+  std::thread thread;
+};
+
+static constexpr int MaxTlsSlots = 16;
+static thread_local u64 __tlsValues[MaxTlsSlots];
+static std::atomic<u32> __tlsSlotCount = 0;
+
+// same frequency as the console, so tick values look the same
+static constexpr s64 TickFrequency = 19200000;
+
+namespace nn::os {
+
+  Tick GetSystemTick() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    s64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    return Tick((s64) ((__int128) ns * TickFrequency / 1000000000));
+  }
+
+  Tick GetSystemTickOrdered() {
+    return GetSystemTick();
+  }
+
+  s64 GetSystemTickFrequency() {
+    return TickFrequency;
+  }
+
+  TimeSpan ConvertToTimeSpan(Tick tick) {
+    return TimeSpan::FromNanoSeconds((s64) ((__int128) tick.GetInt64Value() * 1000000000 / TickFrequency));
+  }
+
+  Tick ConvertToTick(TimeSpan ts) {
+    return Tick((s64) ((__int128) ts.GetNanoSeconds() * TickFrequency / 1000000000));
+  }
+
+  // always recursive, which non-recursive users can't tell apart
+  void InitializeMutex(MutexType *mutex, bool, s32) {
+    MockObjects<MockMutex>::get(mutex);
+  }
+
+  void FinalizeMutex(MutexType *mutex) {
+    MockObjects<MockMutex>::release(mutex);
+  }
+
+  void LockMutex(MutexType *mutex) {
+    MockObjects<MockMutex>::get(mutex).mutex.lock();
+  }
+
+  bool TryLockMutex(MutexType *mutex) {
+    return MockObjects<MockMutex>::get(mutex).mutex.try_lock();
+  }
+
+  void UnlockMutex(MutexType *mutex) {
+    MockObjects<MockMutex>::get(mutex).mutex.unlock();
+  }
+
+  void InitializeEvent(EventType *event, bool initiallySignaled, bool autoclear) {
+    auto &mock = MockObjects<MockEvent>::get(event);
+    mock.isSignaled = initiallySignaled;
+    mock.isAutoClear = autoclear;
+  }
+
+  void FinalizeEvent(EventType *event) {
+    MockObjects<MockEvent>::release(event);
+  }
+
+  void SignalEvent(EventType *event) {
+    auto &mock = MockObjects<MockEvent>::get(event);
+    {
+      std::lock_guard lock(mock.mutex);
+      mock.isSignaled = true;
+    }
+    mock.condition.notify_all();
+  }
+
+  void WaitEvent(EventType *event) {
+    auto &mock = MockObjects<MockEvent>::get(event);
+    std::unique_lock lock(mock.mutex);
+    mock.condition.wait(lock, [&mock]() { return mock.isSignaled; });
+    if (mock.isAutoClear) {
+      mock.isSignaled = false;
+    }
+  }
+
+  bool TryWaitEvent(EventType *event) {
+    auto &mock = MockObjects<MockEvent>::get(event);
+    std::lock_guard lock(mock.mutex);
+    bool isSignaled = mock.isSignaled;
+    if (isSignaled && mock.isAutoClear) {
+      mock.isSignaled = false;
+    }
+    return isSignaled;
+  }
+
+  void ClearEvent(EventType *event) {
+    auto &mock = MockObjects<MockEvent>::get(event);
+    std::lock_guard lock(mock.mutex);
+    mock.isSignaled = false;
+  }
+
+  void InitializeMessageQueue(MessageQueueType *queue, u64 *, u64 queueCount) {
+    MockObjects<MockMessageQueue>::get(queue).capacity = queueCount;
+  }
+
+  void FinalizeMessageQueue(MessageQueueType *queue) {
+    MockObjects<MockMessageQueue>::release(queue);
+  }
+
+  static bool pushMessage(MessageQueueType *queue, u64 message, bool isFront, bool isBlocking) {
+    auto &mock = MockObjects<MockMessageQueue>::get(queue);
+    std::unique_lock lock(mock.mutex);
+
+    if (isBlocking) {
+      mock.notFull.wait(lock, [&mock]() { return mock.messages.size() < mock.capacity; });
+    } else if (mock.messages.size() >= mock.capacity) {
+      return false;
+    }
+
+    if (isFront) {
+      mock.messages.push_front(message);
+    } else {
+      mock.messages.push_back(message);
+    }
+
+    lock.unlock();
+    mock.notEmpty.notify_one();
+    return true;
+  }
+
+  static bool popMessage(u64 *out, MessageQueueType *queue, bool isPeek, bool isBlocking) {
+    auto &mock = MockObjects<MockMessageQueue>::get(queue);
+    std::unique_lock lock(mock.mutex);
+
+    if (isBlocking) {
+      mock.notEmpty.wait(lock, [&mock]() { return !mock.messages.empty(); });
+    } else if (mock.messages.empty()) {
+      return false;
+    }
+
+    *out = mock.messages.front();
+    if (isPeek) {
+      return true;
+    }
+
+    mock.messages.pop_front();
+    lock.unlock();
+    mock.notFull.notify_one();
+    return true;
+  }
+
+  bool TrySendMessageQueue(MessageQueueType *queue, u64 message) {
+    return pushMessage(queue, message, false, false);
+  }
+
+  void SendMessageQueue(MessageQueueType *queue, u64 message) {
+    pushMessage(queue, message, false, true);
+  }
+
+  bool TryJamMessageQueue(MessageQueueType *queue, u64 message) {
+    return pushMessage(queue, message, true, false);
+  }
+
+  void JamMessageQueue(MessageQueueType *queue, u64 message) {
+    pushMessage(queue, message, true, true);
+  }
+
+  bool TryReceiveMessageQueue(u64 *out, MessageQueueType *queue) {
+    return popMessage(out, queue, false, false);
+  }
+
+  void ReceiveMessageQueue(u64 *out, MessageQueueType *queue) {
+    popMessage(out, queue, false, true);
+  }
+
+  bool TryPeekMessageQueue(u64 *out, const MessageQueueType *queue) {
+    return popMessage(out, (MessageQueueType *) queue, true, false);
+  }
+
+  void PeekMessageQueue(u64 *out, const MessageQueueType *queue) {
+    popMessage(out, (MessageQueueType *) queue, true, true);
+  }
+
+  // priorities and cores are left to the host scheduler
+  Result CreateThread(ThreadType *thread, void (*func)(void *), void *arg, void *, u64, s32, s32) {
+    auto &mock = MockObjects<MockThread>::get(thread);
+    mock.func = func;
+    mock.arg = arg;
+    return 0;
+  }
+
+  Result CreateThread(ThreadType *thread, void (*func)(void *), void *arg, void *srcStack, u64 stackSize,
+                      s32 priority) {
+    return CreateThread(thread, func, arg, srcStack, stackSize, priority, -1);
+  }
+
+  void StartThread(ThreadType *thread) {
+    auto &mock = MockObjects<MockThread>::get(thread);
+    mock.thread = std::thread(mock.func, mock.arg);
+  }
+
+  void WaitThread(ThreadType *thread) {
+    auto &mock = MockObjects<MockThread>::get(thread);
+    if (mock.thread.joinable()) {
+      mock.thread.join();
+    }
+  }
+
+  void DestroyThread(ThreadType *thread) {
+    WaitThread(thread);
+    MockObjects<MockThread>::release(thread);
+  }
+
+  void SetThreadName(ThreadType *, const char *) {}
+
+  void SetThreadCoreMask(ThreadType *, int, u64) {}
+
+  void YieldThread() {
+    std::this_thread::yield();
+  }
+
+  Result AllocateTlsSlot(TlsSlot *slot_out, void (*)(u64)) {
+    u32 slot = __tlsSlotCount++;
+    if (slot >= MaxTlsSlots) {
+      return ResultMockFailure;
+    }
+
+    slot_out->slot = slot;
+    return 0;
+  }
+
+  void FreeTlsSlot(TlsSlot) {}
+
+  u64 GetTlsValue(TlsSlot slot) {
+    return __tlsValues[slot.slot];
+  }
+
+  void SetTlsValue(TlsSlot slot, u64 value) {
+    __tlsValues[slot.slot] = value;
+  }
+}
+
+static std::atomic<size_t> __allocationCount = 0;
+
+static void *countedMalloc(size_t size) {
+  __allocationCount++;
+  return malloc(size);
+}
+
+static void *countedAlignedAlloc(size_t alignment, size_t size) {
+  __allocationCount++;
+  // aligned_alloc wants the size to be a multiple of the alignment
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void *countedRealloc(void *ptr, size_t size) {
+  __allocationCount++;
+  return realloc(ptr, size);
+}
+
+size_t NnMock::getAllocationCount() {
+  return __allocationCount;
+}
+
+namespace nn::ro {
+
+  Result Initialize() {
+    return 0;
+  }
+
+  // only the allocator symbols Mem looks up exist, anything else (e.g. GLSLC) is reported missing
+  Result LookupSymbol(uintptr_t *pOutAddress, const char *name) {
+    static const std::pair<const char *, uintptr_t> symbols[] = {
+        {"malloc", (uintptr_t) &countedMalloc},
+        {"aligned_alloc", (uintptr_t) &countedAlignedAlloc},
+        {"free", (uintptr_t) &free},
+        {"realloc", (uintptr_t) &countedRealloc},
+    };
+
+    for (auto &[symbolName, address]: symbols) {
+      if (strcmp(symbolName, name) == 0) {
+        *pOutAddress = address;
+        return 0;
+      }
+    }
+    return ResultMockFailure;
+  }
+}
+
+static std::string __fsRoot = getenv("IMGUI_XENO_HOST_FS_ROOT") ? getenv("IMGUI_XENO_HOST_FS_ROOT") : ".";
+
+void NnMock::setFsRoot(const char *path) {
+  __fsRoot = path;
+}
+
+// drops the mount name, so "rom:/imgui/shaders" becomes "<root>/imgui/shaders"
+static std::filesystem::path resolvePath(const char *path) {
+  const char *mountEnd = strstr(path, ":/");
+  return std::filesystem::path(__fsRoot) / (mountEnd ? mountEnd + 2 : path);
+}
+
+static FILE *getFile(nn::fs::FileHandle handle) {
+  return (FILE *) handle._internal;
+}
+
+namespace nn::fs {
+
+  Result CreateFile(const char *path, s64 size) {
+    std::error_code error;
+    std::filesystem::path hostPath = resolvePath(path);
+
+    FILE *file = fopen(hostPath.c_str(), "wb");
+    if (!file) {
+      return ResultPathNotFound;
+    }
+    fclose(file);
+
+    std::filesystem::resize_file(hostPath, size, error);
+    return error ? ResultMockFailure : 0;
+  }
+
+  Result OpenFile(FileHandle *handleOut, const char *path, int mode) {
+    FILE *file = fopen(resolvePath(path).c_str(), (mode & OpenMode_Write) ? "r+b" : "rb");
+    if (!file) {
+      return ResultPathNotFound;
+    }
+
+    handleOut->_internal = (u64) file;
+    return 0;
+  }
+
+  void CloseFile(FileHandle handle) {
+    fclose(getFile(handle));
+  }
+
+  Result ReadFile(FileHandle handle, long position, void *buffer, ulong size) {
+    FILE *file = getFile(handle);
+    if (fseek(file, position, SEEK_SET) != 0 || fread(buffer, 1, size, file) != size) {
+      return ResultMockFailure;
+    }
+    return 0;
+  }
+
+  Result GetFileSize(long *size, FileHandle handle) {
+    FILE *file = getFile(handle);
+    if (fseek(file, 0, SEEK_END) != 0) {
+      return ResultMockFailure;
+    }
+    *size = ftell(file);
+    return 0;
+  }
+
+  Result SetFileSize(FileHandle handle, s64 size) {
+    FILE *file = getFile(handle);
+    fflush(file);
+    return ftruncate(fileno(file), size) == 0 ? 0 : ResultMockFailure;
+  }
+
+  Result WriteFile(FileHandle handle, s64 position, const void *buffer, u64 size, const WriteOption &option) {
+    FILE *file = getFile(handle);
+    if (fseek(file, position, SEEK_SET) != 0 || fwrite(buffer, 1, size, file) != size) {
+      return ResultMockFailure;
+    }
+    if (option.flags & WriteOptionFlag_Flush) {
+      fflush(file);
+    }
+    return 0;
+  }
+
+  Result CreateDirectory(const char *path) {
+    std::error_code error;
+    return std::filesystem::create_directory(resolvePath(path), error) ? 0 : ResultMockFailure;
+  }
+
+  Result OpenDirectory(DirectoryHandle *handleOut, const char *path, s32) {
+    if (!std::filesystem::is_directory(resolvePath(path))) {
+      return ResultPathNotFound;
+    }
+
+    handleOut->_internal = 0;
+    return 0;
+  }
+
+  void CloseDirectory(DirectoryHandle) {}
+
+  Result GetEntryType(DirectoryEntryType *type, const char *path) {
+    std::filesystem::path hostPath = resolvePath(path);
+
+    if (std::filesystem::is_directory(hostPath)) {
+      *type = DirectoryEntryType_Directory;
+    } else if (std::filesystem::is_regular_file(hostPath)) {
+      *type = DirectoryEntryType_File;
+    } else {
+      return ResultPathNotFound;
+    }
+    return 0;
+  }
+}
+
+namespace nn::util {
+
+  s32 VSNPrintf(char *s, ulong n, const char *format, va_list arg) {
+    return vsnprintf(s, n, format, arg);
+  }
+
+  s32 SNPrintf(char *s, ulong n, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    s32 result = vsnprintf(s, n, format, args);
+    va_end(args);
+    return result;
+  }
+}
+
+namespace nn::diag::detail {
+
+  void AbortImpl(const char *file, const char *func, const char *message, s32 line) {
+    fprintf(stderr, "Abort at %s:%d (%s): %s\n", file, line, func, message);
+    abort();
+  }
+
+  void AbortImpl(const char *file, const char *func, const char *message, int line, Result result) {
+    fprintf(stderr, "Abort at %s:%d (%s): %s (Result: %x)\n", file, line, func, message, (u32) result);
+    abort();
+  }
+}
+
+// GLSLC never gets loaded on the host (LookupSymbol doesn't find it), the backend uses the precompiled shaders
+namespace nn::gfx::detail {
+
+  GlslcDll::GlslcDll() = default;
+
+  GlslcDll::~GlslcDll() = default;
+
+  GlslcDll *GlslcDll::GetInstance() {
+    static GlslcDll instance = {};
+    return &instance;
+  }
+
+  void GlslcDll::Initialize() {}
+
+  void GlslcDll::Finalize() {}
+
+  bool GlslcDll::IsInitialized() const {
+    return false;
+  }
+}
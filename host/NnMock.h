@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// host implementations of the nn:: APIs the backend uses. nn::os maps onto std threads and clocks, nn::ro resolves
+// the libc symbols Mem needs, and nn::fs reads and writes the host file system.
+namespace NnMock {
+
+  // directory mount names (e.g. "rom:/", "sd:/") resolve to. defaults to $IMGUI_XENO_HOST_FS_ROOT, or the working
+  // directory if it isn't set
+  void setFsRoot(const char *path);
+
+  // allocations (malloc, aligned_alloc and realloc) made through the allocator handed out to Mem so far
+  size_t getAllocationCount();
+}
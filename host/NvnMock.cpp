@@ -0,0 +1,410 @@
+#include "NvnMock.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// the mock keeps its state in the reserved bytes of the NVN objects, like the driver does. those are only byte arrays,
+// so the state gets copied in and out of them (see loadState/storeState) instead of being accessed in place
+struct MockMemoryPool {
+  void *storage;
+  size_t size;
+};
+
+struct MockBuffer {
+  uint8_t *ptr;
+  size_t size;
+};
+
+// textures are stored linearly, rows of texels tightly packed. formats other than R8 and RGBA8 keep no texels
+struct MockTexture {
+  int width;
+  int height;
+  int texelSize;
+  uint8_t *texels;
+};
+
+// copies run once the command handle recording them gets submitted, like on the GPU
+struct MockTextureCopy {
+  const uint8_t *src;
+  ptrdiff_t rowStride;
+  const nvn::Texture *texture;
+  nvn::CopyRegion region;
+};
+
+static_assert(sizeof(MockMemoryPool) <= sizeof(nvn::MemoryPoolBuilder) && sizeof(MockBuffer) <= sizeof(nvn::Buffer) &&
+              sizeof(MockBuffer) <= sizeof(nvn::BufferBuilder) && sizeof(MockTexture) <= sizeof(nvn::TextureBuilder),
+              "Mock state doesn't fit in the NVN objects");
+
+template <typename T>
+static T loadState(const void *object) {
+  T state;
+  memcpy(&state, object, sizeof(T));
+  return state;
+}
+
+template <typename T>
+static void storeState(void *object, const T &state) {
+  memcpy(object, &state, sizeof(T));
+}
+
+static std::mutex __callMutex;
+static std::vector<const char *> __calls;
+static std::unordered_map<std::string, int> __callCounts;
+static bool __isRecording = true;
+
+static void recordCall(const char *name) {
+  if (!__isRecording) {
+    return;
+  }
+
+  std::lock_guard lock(__callMutex);
+  __calls.push_back(name);
+  __callCounts[name]++;
+}
+
+static nvn::CommandHandle __lastCommandHandle = 0;
+
+static std::mutex __commandMutex;
+static ptrdiff_t __copyRowStride = 0;
+static std::vector<MockTextureCopy> __recordingCopies;
+static std::unordered_map<nvn::CommandHandle, std::vector<MockTextureCopy>> __handleCopies;
+
+static void writeTextureRegion(const nvn::Texture *texture, const nvn::CopyRegion *region, const void *data,
+                               ptrdiff_t rowStride) {
+  auto state = loadState<MockTexture>(texture);
+  if (!state.texels || state.texelSize == 0) {
+    return;
+  }
+
+  size_t rowSize = (size_t) region->width * state.texelSize;
+  if (rowStride == 0) {
+    rowStride = (ptrdiff_t) rowSize;
+  }
+
+  for (int y = 0; y < region->height; y++) {
+    uint8_t *dst = state.texels + ((size_t) (region->yoffset + y) * state.width + region->xoffset) * state.texelSize;
+    memcpy(dst, (const uint8_t *) data + y * rowStride, rowSize);
+  }
+}
+
+// procs with actual behavior
+
+static void memoryPoolBuilderSetStorage(nvn::MemoryPoolBuilder *builder, void *storage, size_t size) {
+  recordCall("nvnMemoryPoolBuilderSetStorage");
+  storeState(builder, MockMemoryPool{storage, size});
+}
+
+static NVNboolean memoryPoolInitialize(nvn::MemoryPool *pool, const nvn::MemoryPoolBuilder *builder) {
+  recordCall("nvnMemoryPoolInitialize");
+  storeState(pool, loadState<MockMemoryPool>(builder));
+  return true;
+}
+
+static void *memoryPoolMap(const nvn::MemoryPool *pool) {
+  recordCall("nvnMemoryPoolMap");
+  return loadState<MockMemoryPool>(pool).storage;
+}
+
+// GPU addresses are simply the host addresses
+static nvn::BufferAddress memoryPoolGetBufferAddress(const nvn::MemoryPool *pool) {
+  recordCall("nvnMemoryPoolGetBufferAddress");
+  return (nvn::BufferAddress) loadState<MockMemoryPool>(pool).storage;
+}
+
+static size_t memoryPoolGetSize(const nvn::MemoryPool *pool) {
+  recordCall("nvnMemoryPoolGetSize");
+  return loadState<MockMemoryPool>(pool).size;
+}
+
+static void bufferBuilderSetStorage(nvn::BufferBuilder *builder, nvn::MemoryPool *pool, ptrdiff_t offset,
+                                    size_t size) {
+  recordCall("nvnBufferBuilderSetStorage");
+  storeState(builder, MockBuffer{(uint8_t *) loadState<MockMemoryPool>(pool).storage + offset, size});
+}
+
+static NVNboolean bufferInitialize(nvn::Buffer *buffer, const nvn::BufferBuilder *builder) {
+  recordCall("nvnBufferInitialize");
+  storeState(buffer, loadState<MockBuffer>(builder));
+  return true;
+}
+
+static void *bufferMap(const nvn::Buffer *buffer) {
+  recordCall("nvnBufferMap");
+  return loadState<MockBuffer>(buffer).ptr;
+}
+
+static nvn::BufferAddress bufferGetAddress(const nvn::Buffer *buffer) {
+  recordCall("nvnBufferGetAddress");
+  return (nvn::BufferAddress) loadState<MockBuffer>(buffer).ptr;
+}
+
+static size_t bufferGetSize(const nvn::Buffer *buffer) {
+  recordCall("nvnBufferGetSize");
+  return loadState<MockBuffer>(buffer).size;
+}
+
+static void textureBuilderSetDefaults(nvn::TextureBuilder *builder) {
+  recordCall("nvnTextureBuilderSetDefaults");
+  storeState(builder, MockTexture{});
+}
+
+static void textureBuilderSetSize2D(nvn::TextureBuilder *builder, int width, int height) {
+  recordCall("nvnTextureBuilderSetSize2D");
+  auto state = loadState<MockTexture>(builder);
+  state.width = width;
+  state.height = height;
+  storeState(builder, state);
+}
+
+static void textureBuilderSetFormat(nvn::TextureBuilder *builder, nvn::Format::Enum format) {
+  recordCall("nvnTextureBuilderSetFormat");
+  auto state = loadState<MockTexture>(builder);
+  state.texelSize = format == nvn::Format::R8 ? 1 : format == nvn::Format::RGBA8 ? 4 : 0;
+  storeState(builder, state);
+}
+
+static void textureBuilderSetStorage(nvn::TextureBuilder *builder, nvn::MemoryPool *pool, ptrdiff_t offset) {
+  recordCall("nvnTextureBuilderSetStorage");
+  auto state = loadState<MockTexture>(builder);
+  state.texels = (uint8_t *) loadState<MockMemoryPool>(pool).storage + offset;
+  storeState(builder, state);
+}
+
+// linear texels of the format, compressed formats (which keep no texels) get as much as RGBA8 would
+static size_t textureBuilderGetStorageSize(const nvn::TextureBuilder *builder) {
+  recordCall("nvnTextureBuilderGetStorageSize");
+  auto texture = loadState<MockTexture>(builder);
+  return (size_t) texture.width * texture.height * (texture.texelSize > 0 ? texture.texelSize : 4);
+}
+
+static size_t textureBuilderGetStorageAlignment(const nvn::TextureBuilder *) {
+  recordCall("nvnTextureBuilderGetStorageAlignment");
+  return 0x200;
+}
+
+static NVNboolean textureInitialize(nvn::Texture *texture, const nvn::TextureBuilder *builder) {
+  recordCall("nvnTextureInitialize");
+  storeState(texture, loadState<MockTexture>(builder));
+  return true;
+}
+
+static int textureGetWidth(const nvn::Texture *texture) {
+  recordCall("nvnTextureGetWidth");
+  return loadState<MockTexture>(texture).width;
+}
+
+static int textureGetHeight(const nvn::Texture *texture) {
+  recordCall("nvnTextureGetHeight");
+  return loadState<MockTexture>(texture).height;
+}
+
+static void textureWriteTexels(const nvn::Texture *texture, const nvn::TextureView *,
+                               const nvn::CopyRegion *region, const void *data) {
+  recordCall("nvnTextureWriteTexels");
+  writeTextureRegion(texture, region, data, 0);
+}
+
+static void textureWriteTexelsStrided(const nvn::Texture *texture, const nvn::TextureView *,
+                                      const nvn::CopyRegion *region, const void *data, ptrdiff_t rowStride,
+                                      ptrdiff_t) {
+  recordCall("nvnTextureWriteTexelsStrided");
+  writeTextureRegion(texture, region, data, rowStride);
+}
+
+static void commandBufferSetCopyRowStride(nvn::CommandBuffer *, ptrdiff_t stride) {
+  recordCall("nvnCommandBufferSetCopyRowStride");
+  std::lock_guard lock(__commandMutex);
+  __copyRowStride = stride;
+}
+
+static void commandBufferCopyBufferToTexture(nvn::CommandBuffer *, nvn::BufferAddress buffer,
+                                             const nvn::Texture *texture, const nvn::TextureView *,
+                                             const nvn::CopyRegion *region, int) {
+  recordCall("nvnCommandBufferCopyBufferToTexture");
+  std::lock_guard lock(__commandMutex);
+  __recordingCopies.push_back({(const uint8_t *) buffer, __copyRowStride, texture, *region});
+}
+
+// the mock GPU finishes work as soon as it's submitted
+static nvn::SyncWaitResult::Enum syncWait(const nvn::Sync *, uint64_t) {
+  recordCall("nvnSyncWait");
+  return nvn::SyncWaitResult::CONDITION_SATISFIED;
+}
+
+static nvn::CommandHandle commandBufferEndRecording(nvn::CommandBuffer *) {
+  recordCall("nvnCommandBufferEndRecording");
+  std::lock_guard lock(__commandMutex);
+  nvn::CommandHandle handle = ++__lastCommandHandle;
+  if (!__recordingCopies.empty()) {
+    __handleCopies[handle] = std::move(__recordingCopies);
+    __recordingCopies.clear();
+  }
+  return handle;
+}
+
+static void queueSubmitCommands(nvn::Queue *, int count, const nvn::CommandHandle *handles) {
+  recordCall("nvnQueueSubmitCommands");
+  std::lock_guard lock(__commandMutex);
+  for (int i = 0; i < count; i++) {
+    if (auto it = __handleCopies.find(handles[i]); it != __handleCopies.end()) {
+      for (auto &copy: it->second) {
+        writeTextureRegion(copy.texture, &copy.region, copy.src, copy.rowStride);
+      }
+    }
+  }
+}
+
+// values of the real device, for the properties the backend queries
+static void deviceGetInteger(const nvn::Device *, nvn::DeviceInfo::Enum info, int *value) {
+  recordCall("nvnDeviceGetInteger");
+
+  switch (info) {
+    case nvn::DeviceInfo::TEXTURE_DESCRIPTOR_SIZE:
+    case nvn::DeviceInfo::SAMPLER_DESCRIPTOR_SIZE:
+      *value = 0x20;
+      break;
+    case nvn::DeviceInfo::COMMAND_BUFFER_COMMAND_ALIGNMENT:
+      *value = 0x4;
+      break;
+    case nvn::DeviceInfo::COMMAND_BUFFER_CONTROL_ALIGNMENT:
+      *value = 0x8;
+      break;
+    case nvn::DeviceInfo::COMMAND_BUFFER_MIN_COMMAND_SIZE:
+      *value = 0x10000;
+      break;
+    case nvn::DeviceInfo::COMMAND_BUFFER_MIN_CONTROL_SIZE:
+      *value = 0x1000;
+      break;
+    default:
+      *value = 0;
+      break;
+  }
+}
+
+static nvn::TextureHandle deviceGetTextureHandle(const nvn::Device *, int textureId, int samplerId) {
+  recordCall("nvnDeviceGetTextureHandle");
+  return ((nvn::TextureHandle) samplerId << 20) | (nvn::TextureHandle) textureId;
+}
+
+static const std::pair<const char *, nvn::GenericFuncPtrFunc> __mockProcs[] = {
+    {"nvnDeviceGetProcAddress", (nvn::GenericFuncPtrFunc) NvnMock::getProcAddress},
+    {"nvnMemoryPoolBuilderSetStorage", (nvn::GenericFuncPtrFunc) memoryPoolBuilderSetStorage},
+    {"nvnMemoryPoolInitialize", (nvn::GenericFuncPtrFunc) memoryPoolInitialize},
+    {"nvnMemoryPoolMap", (nvn::GenericFuncPtrFunc) memoryPoolMap},
+    {"nvnMemoryPoolGetBufferAddress", (nvn::GenericFuncPtrFunc) memoryPoolGetBufferAddress},
+    {"nvnMemoryPoolGetSize", (nvn::GenericFuncPtrFunc) memoryPoolGetSize},
+    {"nvnBufferBuilderSetStorage", (nvn::GenericFuncPtrFunc) bufferBuilderSetStorage},
+    {"nvnBufferInitialize", (nvn::GenericFuncPtrFunc) bufferInitialize},
+    {"nvnBufferMap", (nvn::GenericFuncPtrFunc) bufferMap},
+    {"nvnBufferGetAddress", (nvn::GenericFuncPtrFunc) bufferGetAddress},
+    {"nvnBufferGetSize", (nvn::GenericFuncPtrFunc) bufferGetSize},
+    {"nvnTextureBuilderSetDefaults", (nvn::GenericFuncPtrFunc) textureBuilderSetDefaults},
+    {"nvnTextureBuilderSetSize2D", (nvn::GenericFuncPtrFunc) textureBuilderSetSize2D},
+    {"nvnTextureBuilderSetFormat", (nvn::GenericFuncPtrFunc) textureBuilderSetFormat},
+    {"nvnTextureBuilderSetStorage", (nvn::GenericFuncPtrFunc) textureBuilderSetStorage},
+    {"nvnTextureBuilderGetStorageSize", (nvn::GenericFuncPtrFunc) textureBuilderGetStorageSize},
+    {"nvnTextureBuilderGetStorageAlignment", (nvn::GenericFuncPtrFunc) textureBuilderGetStorageAlignment},
+    {"nvnTextureInitialize", (nvn::GenericFuncPtrFunc) textureInitialize},
+    {"nvnTextureGetWidth", (nvn::GenericFuncPtrFunc) textureGetWidth},
+    {"nvnTextureGetHeight", (nvn::GenericFuncPtrFunc) textureGetHeight},
+    {"nvnTextureWriteTexels", (nvn::GenericFuncPtrFunc) textureWriteTexels},
+    {"nvnTextureWriteTexelsStrided", (nvn::GenericFuncPtrFunc) textureWriteTexelsStrided},
+    {"nvnCommandBufferSetCopyRowStride", (nvn::GenericFuncPtrFunc) commandBufferSetCopyRowStride},
+    {"nvnCommandBufferCopyBufferToTexture", (nvn::GenericFuncPtrFunc) commandBufferCopyBufferToTexture},
+    {"nvnSyncWait", (nvn::GenericFuncPtrFunc) syncWait},
+    {"nvnCommandBufferEndRecording", (nvn::GenericFuncPtrFunc) commandBufferEndRecording},
+    {"nvnQueueSubmitCommands", (nvn::GenericFuncPtrFunc) queueSubmitCommands},
+    {"nvnDeviceGetInteger", (nvn::GenericFuncPtrFunc) deviceGetInteger},
+    {"nvnDeviceGetTextureHandle", (nvn::GenericFuncPtrFunc) deviceGetTextureHandle},
+};
+
+// every other proc gets a stub of its own, so calls can be told apart. stubs ignore their arguments and return a
+// fixed value, which works for the integer/pointer returning procs of the AArch64 and x86-64 calling conventions
+static constexpr size_t MaxGenericProcs = 1024;
+
+struct GenericProc {
+  const char *name;
+  uintptr_t result;
+};
+
+static GenericProc __genericProcs[MaxGenericProcs];
+static size_t __genericProcCount = 0;
+static std::unordered_map<std::string, nvn::GenericFuncPtrFunc> __procCache;
+
+template <size_t Idx>
+static uintptr_t genericProc() {
+  recordCall(__genericProcs[Idx].name);
+  return __genericProcs[Idx].result;
+}
+
+template <size_t... Idx>
+static auto makeGenericProcs(std::index_sequence<Idx...>) {
+  return std::array<nvn::GenericFuncPtrFunc, sizeof...(Idx)>{(nvn::GenericFuncPtrFunc) genericProc<Idx>...};
+}
+
+static const auto __genericProcFuncs = makeGenericProcs(std::make_index_sequence<MaxGenericProcs>());
+
+static bool endsWith(const std::string &str, const char *suffix) {
+  size_t suffixLen = strlen(suffix);
+  return str.size() >= suffixLen && str.compare(str.size() - suffixLen, suffixLen, suffix) == 0;
+}
+
+nvn::GenericFuncPtrFunc NvnMock::getProcAddress(const nvn::Device *, const char *name) {
+  for (auto &[procName, func]: __mockProcs) {
+    if (strcmp(procName, name) == 0) {
+      return func;
+    }
+  }
+
+  std::lock_guard lock(__callMutex);
+
+  std::string key = name;
+  if (auto it = __procCache.find(key); it != __procCache.end()) {
+    return it->second;
+  }
+
+  if (__genericProcCount >= MaxGenericProcs) {
+    return nullptr;
+  }
+
+  GenericProc &proc = __genericProcs[__genericProcCount];
+  proc.name = strdup(name);
+  // initialization always succeeds, so the backend sets up like it would on hardware
+  proc.result = endsWith(key, "Initialize") || endsWith(key, "SetShaders") ? 1 : 0;
+
+  nvn::GenericFuncPtrFunc func = __genericProcFuncs[__genericProcCount++];
+  __procCache[key] = func;
+  return func;
+}
+
+void *NvnMock::bootstrapLoader(const char *name) {
+  return (void *) getProcAddress(nullptr, name);
+}
+
+void NvnMock::setRecording(bool isRecording) {
+  __isRecording = isRecording;
+}
+
+void NvnMock::clearCalls() {
+  std::lock_guard lock(__callMutex);
+  __calls.clear();
+  __callCounts.clear();
+}
+
+const std::vector<const char *> &NvnMock::getCalls() {
+  return __calls;
+}
+
+int NvnMock::getCallCount(const char *name) {
+  std::lock_guard lock(__callMutex);
+  auto it = __callCounts.find(name);
+  return it != __callCounts.end() ? it->second : 0;
+}
+
+const uint8_t *NvnMock::getTexels(const nvn::Texture *texture) {
+  return loadState<MockTexture>(texture).texels;
+}
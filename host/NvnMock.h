@@ -0,0 +1,30 @@
+#pragma once
+
+#include "nvn_Cpp.h"
+#include <cstdint>
+#include <vector>
+
+// stands in for the game's NVN driver on host builds. every proc gets looked up through getProcAddress, and each call
+// gets recorded by name. procs the backend depends on behave well enough for it to run (memory pools hand out host
+// memory, syncs are always signaled, ...), every other one does nothing and returns 0.
+namespace NvnMock {
+
+  // what a game would get from nvnBootstrapLoader, pass it as the original to imgui_xeno_bootstrap_hook
+  void *bootstrapLoader(const char *name);
+
+  nvn::GenericFuncPtrFunc getProcAddress(const nvn::Device *device, const char *name);
+
+  // calls are only recorded while enabled, so long runs (benchmarks) don't grow the log forever
+  void setRecording(bool isRecording);
+
+  void clearCalls();
+
+  // names of the procs called since the last clearCalls, in order
+  const std::vector<const char *> &getCalls();
+
+  int getCallCount(const char *name);
+
+  // the storage of an R8 or RGBA8 texture, rows of texels tightly packed. CopyBufferToTexture writes it once the
+  // command handle is submitted, WriteTexels right away
+  const uint8_t *getTexels(const nvn::Texture *texture);
+}
@@ -0,0 +1,361 @@
+// Replays draw data captures through renderDrawData against the mock NVN driver, and reports the cost of recording
+// them: time per uploaded vertex, NVN commands per ImDrawCmd, command memory and allocations per frame.
+//
+// usage: imgui_xeno_bench [--iterations N] [--generate DIR] [--copy] [capture files...]
+//
+// without capture files, the built-in scenes (demo window, large table, plots, thousands of text lines) are
+// benchmarked. --generate writes them to DIR as capture files instead, to build a corpus that stays the same between
+// ImGui updates. --copy measures the throughput of Mem::CopyNonTemporal against memcpy instead.
+
+#include "NnMock.h"
+#include "NvnMock.h"
+#include "helpers/memoryHelper.h"
+#include "imgui_backend/DrawDataCapture.h"
+#include "imgui_backend/imgui_impl_nvn.hpp"
+#include "imgui_backend/imgui_nvn.h"
+#include "imgui_xeno.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Scene {
+  const char *name;
+  void (*draw)();
+};
+
+struct BenchResult {
+  double nsPerFrame;
+  double nsPerVertex;
+  double commandsPerCmd;
+  double allocationsPerFrame;
+  int commands;
+  size_t commandMemory;
+};
+
+static nvn::Device __device;
+static nvn::Queue __queue;
+
+// goes through the same hooks a game would, then sets up ImGui and the backend on the mock device
+static bool setupBackend() {
+
+  auto getProcAddress = (nvn::DeviceGetProcAddressFunc) imgui_xeno_bootstrap_hook("nvnDeviceGetProcAddress",
+                                                                                  NvnMock::bootstrapLoader);
+  auto deviceInit = (nvn::DeviceInitializeFunc) imgui_xeno_bootstrap_hook("nvnDeviceInitialize",
+                                                                          NvnMock::bootstrapLoader);
+
+  nvn::DeviceBuilder deviceBuilder = {};
+  deviceInit(&__device, &deviceBuilder);
+
+  auto queueInit = (nvn::QueueInitializeFunc) getProcAddress(&__device, "nvnQueueInitialize");
+  nvn::QueueBuilder queueBuilder = {};
+  queueInit(&__queue, &queueBuilder);
+
+  return nvnImGui::InitImGui() && ImguiNvnBackend::getBackendData()->isInitialized;
+}
+
+static void fullscreenWindow(const char *name) {
+  ImGui::SetNextWindowPos(ImVec2(0, 0));
+  ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+  ImGui::Begin(name, nullptr, ImGuiWindowFlags_NoSavedSettings);
+}
+
+static void drawDemoScene() {
+  ImGui::ShowDemoWindow();
+}
+
+static void drawTableScene() {
+  fullscreenWindow("Table");
+
+  if (ImGui::BeginTable("table", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable)) {
+    for (int row = 0; row < 1000; row++) {
+      ImGui::TableNextRow();
+      for (int column = 0; column < 8; column++) {
+        ImGui::TableNextColumn();
+        ImGui::Text("Cell %d,%d: %08X", row, column, row * 8 + column);
+      }
+    }
+    ImGui::EndTable();
+  }
+
+  ImGui::End();
+}
+
+static void drawPlotScene() {
+  fullscreenWindow("Plots");
+
+  static float values[2000];
+  for (int i = 0; i < IM_ARRAYSIZE(values); i++) {
+    values[i] = sinf((float) i * 0.05f) + cosf((float) i * 0.013f) * 0.5f;
+  }
+
+  ImVec2 plotSize(ImGui::GetContentRegionAvail().x, 100.0f);
+  for (int i = 0; i < 4; i++) {
+    ImGui::PushID(i);
+    ImGui::PlotLines("##lines", values + i * 100, IM_ARRAYSIZE(values) - i * 100, 0, nullptr, -1.5f, 1.5f, plotSize);
+    ImGui::PopID();
+  }
+  ImGui::PlotHistogram("##histogram", values, 500, 0, nullptr, -1.5f, 1.5f, plotSize);
+
+  ImGui::End();
+}
+
+// lines overlap once they fill the display, so every one of them produces vertices
+static void drawTextScene() {
+  ImDrawList *drawList = ImGui::GetForegroundDrawList();
+  ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+  float lineHeight = ImGui::GetTextLineHeight();
+  int linesPerColumn = (int) (displaySize.y / lineHeight);
+
+  char line[64];
+  for (int i = 0; i < 4000; i++) {
+    snprintf(line, sizeof(line), "Line %04d: the quick brown fox", i);
+    ImVec2 pos((float) (i / linesPerColumn) * 24.0f, (float) (i % linesPerColumn) * lineHeight);
+    drawList->AddText(pos, IM_COL32(255, 255, 255, 255), line);
+  }
+}
+
+static const Scene __scenes[] = {
+    {"demo", drawDemoScene},
+    {"tables", drawTableScene},
+    {"plots", drawPlotScene},
+    {"text", drawTextScene},
+};
+
+// runs a few frames first, so auto-sized windows and tables have settled. they get rendered too, as that is where
+// the textures ImGui creates (e.g. the dynamic font atlas) get their IDs, which the capture needs
+static bool captureScene(const Scene &scene, ImVector<u8> &out) {
+
+  ImGuiIO &io = ImGui::GetIO();
+  io.DeltaTime = 1.0f / 60.0f;
+
+  for (int i = 0; i < 3; i++) {
+    ImGui::NewFrame();
+    scene.draw();
+    ImGui::Render();
+    ImguiNvnBackend::invalidateRecordedFrame();
+    ImguiNvnBackend::renderDrawData(ImGui::GetDrawData());
+  }
+
+  return DrawDataCapture::write(ImGui::GetDrawData(), out);
+}
+
+static bool loadFile(const char *path, ImVector<u8> &out) {
+
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  out.resize((int) ftell(file));
+  fseek(file, 0, SEEK_SET);
+
+  bool isRead = fread(out.Data, 1, out.Size, file) == (size_t) out.Size;
+  fclose(file);
+  return isRead;
+}
+
+static bool saveFile(const char *path, const ImVector<u8> &data) {
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  bool isWritten = fwrite(data.Data, 1, data.Size, file) == (size_t) data.Size;
+  fclose(file);
+  return isWritten;
+}
+
+static int countCommandBufferCalls() {
+  int count = 0;
+  for (auto name: NvnMock::getCalls()) {
+    if (strncmp(name, "nvnCommandBuffer", strlen("nvnCommandBuffer")) == 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+static BenchResult benchCapture(DrawDataCapture::Capture &capture, int iterations) {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+  ImDrawData *drawData = &capture.drawData;
+  ImGui::GetIO().DisplaySize = drawData->DisplaySize;
+
+  // one instrumented frame to count the commands, call recording is too slow to leave on while timing
+  NvnMock::setRecording(true);
+  NvnMock::clearCalls();
+  ImguiNvnBackend::invalidateRecordedFrame();
+  ImguiNvnBackend::renderDrawData(drawData);
+  int commands = countCommandBufferCalls();
+  NvnMock::setRecording(false);
+
+  // the recording frame's memory, which grows to fit the biggest frame recorded into it
+  auto &cmdMemory = bd->frames[(bd->frameIndex + ImguiNvnBackend::FramesInFlight - 1) %
+                               ImguiNvnBackend::FramesInFlight].cmdMemory;
+  size_t commandMemory = cmdMemory.commandSize + cmdMemory.controlSize;
+
+  // warms up every frame of the ring, so buffer growth isn't measured
+  for (int i = 0; i < ImguiNvnBackend::FramesInFlight; i++) {
+    ImguiNvnBackend::invalidateRecordedFrame();
+    ImguiNvnBackend::renderDrawData(drawData);
+  }
+
+  size_t startAllocations = NnMock::getAllocationCount();
+  auto start = std::chrono::steady_clock::now();
+
+  // unchanged frames would otherwise be replayed, this measures recording them
+  for (int i = 0; i < iterations; i++) {
+    ImguiNvnBackend::invalidateRecordedFrame();
+    ImguiNvnBackend::renderDrawData(drawData);
+  }
+
+  double elapsedNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  size_t allocations = NnMock::getAllocationCount() - startAllocations;
+
+  double nsPerFrame = elapsedNs / iterations;
+  return {
+      .nsPerFrame = nsPerFrame,
+      .nsPerVertex = drawData->TotalVtxCount > 0 ? nsPerFrame / drawData->TotalVtxCount : 0.0,
+      .commandsPerCmd = bd->drawStats.cmdsIn > 0 ? (double) commands / bd->drawStats.cmdsIn : 0.0,
+      .allocationsPerFrame = (double) allocations / iterations,
+      .commands = commands,
+      .commandMemory = commandMemory
+  };
+}
+
+static void printResult(const char *name, DrawDataCapture::Capture &capture, const BenchResult &result) {
+  auto bd = ImguiNvnBackend::getBackendData();
+  printf("%-24s %8d %8d %6d %6d %10.0f %8.2f %8d %8.2f %8d %10zu %8.2f\n", name, capture.drawData.TotalVtxCount,
+         capture.drawData.TotalIdxCount, bd->drawStats.cmdsIn, bd->drawStats.drawsOut, result.nsPerFrame,
+         result.nsPerVertex, result.commands, result.commandsPerCmd, bd->drawStats.skippedBinds, result.commandMemory,
+         result.allocationsPerFrame);
+}
+
+// seconds it takes to copy totalSize bytes in blocks of size, the first copy warms up the caches and isn't counted
+static double timeCopy(void (*copy)(void *, const void *, size_t), u8 *dst, const u8 *src, size_t size,
+                       size_t totalSize) {
+
+  copy(dst, src, size);
+
+  size_t count = totalSize / size;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    copy(dst, src, size);
+  }
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the two copies IMGUI_XENO_NON_TEMPORAL_UPLOAD picks between for stream uploads, at upload sizes from a small window
+// to a large table. only AArch64 builds have a non-temporal path, elsewhere both columns are memcpy. host memory is
+// cacheable, so this shows the cost of the copy loop, not the effect of write-combined memory on the console
+static void benchCopies() {
+
+  static constexpr size_t Sizes[] = {0x1000, 0x10000, 0x100000, 0x1000000};
+  static constexpr size_t TotalSize = 0x40000000;
+
+  std::vector<u8> src(Sizes[IM_ARRAYSIZE(Sizes) - 1], 0x5A);
+  std::vector<u8> dst(src.size());
+
+  auto copyMemcpy = [](void *dst, const void *src, size_t size) { memcpy(dst, src, size); };
+
+#ifdef __aarch64__
+  printf("non-temporal copies use stnp\n");
+#else
+  printf("not an AArch64 build, non-temporal copies fall back to memcpy\n");
+#endif
+  printf("%10s %12s %12s %8s\n", "size", "memcpy GB/s", "nt GB/s", "nt/mc");
+
+  for (size_t size: Sizes) {
+    double memcpySec = timeCopy(copyMemcpy, dst.data(), src.data(), size, TotalSize);
+    double ntSec = timeCopy(Mem::CopyNonTemporal, dst.data(), src.data(), size, TotalSize);
+    double gigabytes = (double) (TotalSize / size * size) / 1e9;
+    printf("%10zu %12.2f %12.2f %8.2f\n", size, gigabytes / memcpySec, gigabytes / ntSec, memcpySec / ntSec);
+  }
+}
+
+int main(int argc, char **argv) {
+
+  int iterations = 1000;
+  const char *generateDir = nullptr;
+  bool isCopyBench = false;
+  std::vector<const char *> capturePaths;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+      generateDir = argv[++i];
+    } else if (strcmp(argv[i], "--copy") == 0) {
+      isCopyBench = true;
+    } else {
+      capturePaths.push_back(argv[i]);
+    }
+  }
+
+  // doesn't need the backend
+  if (isCopyBench) {
+    benchCopies();
+    return 0;
+  }
+
+  if (iterations <= 0 || !setupBackend()) {
+    fprintf(stderr, "Failed to set up the backend\n");
+    return 1;
+  }
+
+  if (generateDir) {
+    for (auto &scene: __scenes) {
+      ImVector<u8> data;
+      std::string path = std::string(generateDir) + "/" + scene.name + ".xcap";
+      if (!captureScene(scene, data) || !saveFile(path.c_str(), data)) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+        return 1;
+      }
+      printf("Wrote %s (%d bytes)\n", path.c_str(), data.Size);
+    }
+    return 0;
+  }
+
+  printf("%-24s %8s %8s %6s %6s %10s %8s %8s %8s %8s %10s %8s\n", "capture", "vtx", "idx", "cmds", "draws",
+         "ns/frame", "ns/vtx", "nvn cmds", "per cmd", "skipped", "cmd mem", "allocs");
+
+  auto runCapture = [iterations](const char *name, const ImVector<u8> &data) {
+    DrawDataCapture::Capture capture = {};
+    bool isRead = DrawDataCapture::read(data.Data, data.Size, capture);
+    if (isRead) {
+      printResult(name, capture, benchCapture(capture, iterations));
+    }
+    DrawDataCapture::release(capture);
+    return isRead;
+  };
+
+  // built-in scenes go through the capture format too, so they are replayed exactly like capture files
+  if (capturePaths.empty()) {
+    for (auto &scene: __scenes) {
+      ImVector<u8> data;
+      if (!captureScene(scene, data) || !runCapture(scene.name, data)) {
+        fprintf(stderr, "Failed to capture scene %s\n", scene.name);
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  for (auto path: capturePaths) {
+    ImVector<u8> data;
+    if (!loadFile(path, data) || !runCapture(path, data)) {
+      fprintf(stderr, "Failed to load capture %s\n", path);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Reads back a draw data capture, then damaged copies of it, and checks that every one of them gets rejected before
+// renderDrawData could read past the buffers they describe. Also checks what writing a capture produces.
+//
+// usage: imgui_xeno_draw_data_capture_test
+
+#include "TestSupport.h"
+#include <cstddef>
+#include <cstring>
+
+static constexpr int QuadCount = 2;
+static constexpr nvn::TextureHandle Texture = 0x1234;
+
+static constexpr size_t ListOffset = sizeof(DrawDataCapture::Header);
+static constexpr size_t VtxOffset = ListOffset + sizeof(DrawDataCapture::ListHeader);
+static constexpr size_t IdxOffset = VtxOffset + QuadCount * 4 * sizeof(ImDrawVert);
+static constexpr size_t CmdOffset = IdxOffset + QuadCount * 6 * sizeof(ImDrawIdx);
+
+template <typename T>
+static std::vector<u8> patch(std::vector<u8> data, size_t offset, T value) {
+  memcpy(data.data() + offset, &value, sizeof(T));
+  return data;
+}
+
+static bool isReadable(const std::vector<u8> &data) {
+  DrawDataCapture::Capture capture = {};
+  bool result = DrawDataCapture::read(data.data(), data.size(), capture);
+  DrawDataCapture::release(capture);
+  return result;
+}
+
+static void testRead(const std::vector<u8> &data) {
+
+  DrawDataCapture::Capture capture = {};
+  EXPECT(DrawDataCapture::read(data.data(), data.size(), capture));
+  EXPECT(capture.lists.Size == 1 && capture.drawData.CmdListsCount == 1);
+  EXPECT(capture.drawData.TotalVtxCount == QuadCount * 4 && capture.drawData.TotalIdxCount == QuadCount * 6);
+  EXPECT(capture.drawData.DisplaySize.x == 1280.0f && capture.drawData.DisplaySize.y == 720.0f);
+
+  if (capture.lists.Size == 1 && capture.lists[0]->CmdBuffer.Size == 1) {
+    const ImDrawCmd &cmd = capture.lists[0]->CmdBuffer[0];
+    EXPECT(cmd.ElemCount == QuadCount * 6 && cmd.IdxOffset == 0 && cmd.VtxOffset == 0);
+    EXPECT(*(const nvn::TextureHandle *) (intptr_t) cmd.GetTexID() == Texture);
+    EXPECT(memcmp(capture.lists[0]->VtxBuffer.Data, data.data() + VtxOffset, IdxOffset - VtxOffset) == 0);
+  }
+
+  DrawDataCapture::release(capture);
+}
+
+static void testTruncated(const std::vector<u8> &data) {
+  for (size_t size = 0; size < data.size(); size++) {
+    EXPECT(!isReadable(std::vector<u8>(data.begin(), data.begin() + (ptrdiff_t) size)));
+  }
+
+  // counts that claim more than the capture holds are caught before anything gets sized from them
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, totalCmdCount), (s32) 0x7FFFFFFF)));
+  EXPECT(!isReadable(patch(data, ListOffset + offsetof(DrawDataCapture::ListHeader, vtxCount), (s32) 0x7FFFFFFF)));
+  EXPECT(!isReadable(patch(data, ListOffset + offsetof(DrawDataCapture::ListHeader, cmdCount), (s32) 2)));
+}
+
+static void testInvalid(const std::vector<u8> &data) {
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, magic), (u32) 0)));
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, version), DrawDataCapture::Version + 1)));
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, vtxStride), (u32) sizeof(ImDrawVert) + 4)));
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, listCount), (s32) -1)));
+  EXPECT(!isReadable(patch(data, ListOffset + offsetof(DrawDataCapture::ListHeader, idxCount), (s32) -6)));
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, totalVtxCount), (s32) QuadCount * 4 + 1)));
+  EXPECT(!isReadable(patch(data, offsetof(DrawDataCapture::Header, totalIdxCount), (s32) QuadCount * 6 - 1)));
+}
+
+static void testOutOfRange(const std::vector<u8> &data) {
+
+  // past the end of the index buffer
+  EXPECT(!isReadable(patch(data, CmdOffset + offsetof(DrawDataCapture::CmdData, elemCount), (u32) QuadCount * 6 + 3)));
+  EXPECT(!isReadable(patch(data, CmdOffset + offsetof(DrawDataCapture::CmdData, idxOffset), (u32) 3)));
+
+  // addressing vertices past the end of the vertex buffer, through an index or the command's vertex offset
+  EXPECT(!isReadable(patch(data, IdxOffset + sizeof(ImDrawIdx), (ImDrawIdx) (QuadCount * 4))));
+  EXPECT(!isReadable(patch(data, CmdOffset + offsetof(DrawDataCapture::CmdData, vtxOffset), (u32) QuadCount * 4)));
+  EXPECT(!isReadable(patch(data, CmdOffset + offsetof(DrawDataCapture::CmdData, vtxOffset), (u32) 1)));
+
+  // the last index addresses the last vertex, which is still fine
+  EXPECT(isReadable(patch(data, IdxOffset + sizeof(ImDrawIdx), (ImDrawIdx) (QuadCount * 4 - 1))));
+}
+
+// writing a capture back out gives the same bytes, padding included
+static void testWrite(const std::vector<u8> &data) {
+
+  DrawDataCapture::Capture capture = {};
+  EXPECT(DrawDataCapture::read(data.data(), data.size(), capture));
+
+  ImVector<u8> out;
+  EXPECT(DrawDataCapture::write(&capture.drawData, out));
+  EXPECT(out.Size == (int) data.size() && memcmp(out.Data, data.data(), data.size()) == 0);
+
+  // a command without a texture can't be replayed, so it isn't captured
+  if (capture.lists.Size == 1 && capture.lists[0]->CmdBuffer.Size == 1) {
+#if IMGUI_VERSION_NUM >= 19200
+    capture.lists[0]->CmdBuffer[0].TexRef = ImTextureRef();
+#else
+    capture.lists[0]->CmdBuffer[0].TextureId = ImTextureID();
+#endif
+    out.resize(0);
+    EXPECT(!DrawDataCapture::write(&capture.drawData, out));
+  }
+
+  DrawDataCapture::release(capture);
+}
+
+int main() {
+
+  auto data = HostTest::makeQuadCapture(QuadCount, Texture);
+  EXPECT(data.size() == CmdOffset + sizeof(DrawDataCapture::CmdData));
+
+  testRead(data);
+  testTruncated(data);
+  testInvalid(data);
+  testOutOfRange(data);
+  testWrite(data);
+
+  HostTest::finish();
+}
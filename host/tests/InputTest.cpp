@@ -0,0 +1,184 @@
+// Feeds input through the HID mock, and checks how InputHelper reports it across updates, and which mouse positions
+// the backend then hands to ImGui.
+//
+// usage: imgui_xeno_input_test
+
+#include "HidMock.h"
+#include "TestSupport.h"
+#include "helpers/InputHelper.h"
+#include "imgui_backend/imgui_impl_nvn.hpp"
+#include "imgui_internal.h"
+
+template <s32 size, typename T>
+static void setBit(nn::util::BitFlagSet<size, T> &set, T index) {
+  using Set = nn::util::BitFlagSet<size, T>;
+  set.field[(u64) index / Set::storageBits] |= (typename Set::type) 1 << (u64) index % Set::storageBits;
+}
+
+static void testButtons() {
+
+  nn::hid::NpadBaseState npad = {};
+  nn::hid::KeyboardState keyboard = {};
+  nn::hid::MouseState mouse = {};
+  setBit(npad.mButtons, nn::hid::NpadButton::A);
+  setBit(keyboard.keys, nn::hid::KeyboardKey::A);
+  setBit(mouse.buttons, nn::hid::MouseButton::Left);
+  HidMock::setNpadState(npad);
+  HidMock::setKeyboardState(keyboard);
+  HidMock::setMouseState(mouse);
+
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isButtonPress(nn::hid::NpadButton::A) && InputHelper::isButtonHold(nn::hid::NpadButton::A));
+  EXPECT(!InputHelper::isButtonHold(nn::hid::NpadButton::B));
+  EXPECT(InputHelper::isKeyPress(nn::hid::KeyboardKey::A) && InputHelper::isKeyHold(nn::hid::KeyboardKey::A));
+  EXPECT(!InputHelper::isKeyHold(nn::hid::KeyboardKey::B));
+  EXPECT(InputHelper::isMousePress(nn::hid::MouseButton::Left));
+  EXPECT(!InputHelper::isMouseHold(nn::hid::MouseButton::Right));
+  EXPECT(InputHelper::isInputActive());
+
+  // the same state again is only held
+  InputHelper::updatePadState();
+  EXPECT(!InputHelper::isButtonPress(nn::hid::NpadButton::A) && InputHelper::isButtonHold(nn::hid::NpadButton::A));
+  EXPECT(!InputHelper::isKeyPress(nn::hid::KeyboardKey::A) && InputHelper::isKeyHold(nn::hid::KeyboardKey::A));
+  EXPECT(!InputHelper::isMousePress(nn::hid::MouseButton::Left) &&
+         InputHelper::isMouseHold(nn::hid::MouseButton::Left));
+
+  HidMock::setNpadState({});
+  HidMock::setKeyboardState({});
+  HidMock::setMouseState({});
+
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isButtonRelease(nn::hid::NpadButton::A) && !InputHelper::isButtonHold(nn::hid::NpadButton::A));
+  EXPECT(InputHelper::isKeyRelease(nn::hid::KeyboardKey::A));
+  EXPECT(InputHelper::isMouseRelease(nn::hid::MouseButton::Left));
+
+  InputHelper::updatePadState();
+  EXPECT(!InputHelper::isButtonRelease(nn::hid::NpadButton::A) && !InputHelper::isKeyRelease(nn::hid::KeyboardKey::A));
+  EXPECT(!InputHelper::isInputActive());
+}
+
+// holding one stick button and pressing the other flips whether the pad drives ImGui
+static void testToggle() {
+
+  bool wasToggled = InputHelper::isInputToggled();
+
+  nn::hid::NpadBaseState npad = {};
+  setBit(npad.mButtons, nn::hid::NpadButton::StickL);
+  HidMock::setNpadState(npad);
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isInputToggled() == wasToggled);
+
+  setBit(npad.mButtons, nn::hid::NpadButton::StickR);
+  HidMock::setNpadState(npad);
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isInputToggled() != wasToggled);
+
+  // still holding both doesn't flip it back
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isInputToggled() != wasToggled);
+
+  HidMock::setNpadState({});
+  InputHelper::updatePadState();
+}
+
+static void testPointers() {
+
+  nn::hid::MouseState mouse = {};
+  mouse.x = 320;
+  mouse.y = 180;
+  mouse.wheelDeltaX = -2;
+  HidMock::setMouseState(mouse);
+
+  InputHelper::updatePadState();
+  float x = 0.0f, y = 0.0f;
+  InputHelper::getMouseCoords(&x, &y);
+  EXPECT(x == 320.0f && y == 180.0f);
+  InputHelper::getScrollDelta(&x, &y);
+  EXPECT(x == -2.0f && y == 0.0f);
+
+  nn::hid::TouchScreenState<1> touch = {};
+  touch.count = 1;
+  touch.touches[0].X = 100;
+  touch.touches[0].Y = 200;
+  HidMock::setTouchState(touch);
+
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isTouchPress() && !InputHelper::isTouchRelease());
+  EXPECT(InputHelper::getTouchCoords(&x, &y) && x == 100.0f && y == 200.0f);
+
+  InputHelper::updatePadState();
+  EXPECT(!InputHelper::isTouchPress());
+
+  HidMock::setTouchState({});
+  HidMock::setMouseState({});
+  InputHelper::updatePadState();
+  EXPECT(InputHelper::isTouchRelease() && !InputHelper::getTouchCoords(&x, &y));
+}
+
+// the last mouse position ImGui got since the queue was cleared
+static bool getQueuedMousePos(ImVec2 *pos, int *eventCount) {
+
+  *eventCount = 0;
+  for (const ImGuiInputEvent &event: GImGui->InputEventsQueue) {
+    if (event.Type == ImGuiInputEventType_MousePos) {
+      *pos = ImVec2(event.MousePos.PosX, event.MousePos.PosY);
+      (*eventCount)++;
+    }
+  }
+  return *eventCount > 0;
+}
+
+// positions are reported in the viewport's resolution, and get scaled to the display size
+static void testBackendTranslation() {
+
+  ImGuiIO &io = ImGui::GetIO();
+  io.DisplaySize = ImVec2(IMGUI_XENO_VIEWPORT_WIDTH * 1.5f, IMGUI_XENO_VIEWPORT_HEIGHT * 1.5f);
+
+  nn::hid::MouseState mouse = {};
+  mouse.x = IMGUI_XENO_VIEWPORT_WIDTH / 2;
+  mouse.y = IMGUI_XENO_VIEWPORT_HEIGHT / 4;
+  HidMock::setMouseState(mouse);
+
+  ImVec2 pos;
+  int eventCount = 0;
+
+  GImGui->InputEventsQueue.resize(0);
+  ImguiNvnBackend::pollInput();
+#if IMGUI_XENO_INPUT_KBM
+  EXPECT(getQueuedMousePos(&pos, &eventCount) && eventCount == 1);
+  EXPECT(pos.x == io.DisplaySize.x / 2 && pos.y == io.DisplaySize.y / 4);
+#endif
+
+  // while the screen is touched the mouse is ignored
+  nn::hid::TouchScreenState<1> touch = {};
+  touch.count = 1;
+  touch.touches[0].X = IMGUI_XENO_VIEWPORT_WIDTH;
+  touch.touches[0].Y = IMGUI_XENO_VIEWPORT_HEIGHT / 2;
+  HidMock::setTouchState(touch);
+
+  GImGui->InputEventsQueue.resize(0);
+  ImguiNvnBackend::pollInput();
+#if IMGUI_XENO_INPUT_TOUCH
+  EXPECT(getQueuedMousePos(&pos, &eventCount) && eventCount == 1);
+  EXPECT(pos.x == io.DisplaySize.x && pos.y == io.DisplaySize.y / 2);
+#endif
+
+  HidMock::setTouchState({});
+  HidMock::setMouseState({});
+  ImguiNvnBackend::pollInput();
+  GImGui->InputEventsQueue.resize(0);
+}
+
+int main() {
+
+  if (!HostTest::setupBackend()) {
+    return 1;
+  }
+
+  testButtons();
+  testToggle();
+  testPointers();
+  testBackendTranslation();
+
+  HostTest::finish();
+}
@@ -0,0 +1,122 @@
+// Allocates from a memory arena of its own against the mock NVN driver, and checks how the buddy allocator splits and
+// merges blocks, that allocations are aligned, and which memory pools get created and released on the way.
+//
+// usage: imgui_xeno_memory_arena_test
+
+#include "NvnMock.h"
+#include "TestSupport.h"
+#include "imgui_backend/MemoryArena.h"
+
+// no buffer or texture of the backend lives in this arena, so it starts out empty
+static const nvn::MemoryPoolFlags ArenaFlags = nvn::MemoryPoolFlags::CPU_CACHED | nvn::MemoryPoolFlags::GPU_UNCACHED;
+
+static constexpr size_t HalfChunkSize = MemoryArena::ChunkSize / 2;
+
+static bool allocate(MemoryArena::Allocation *result, size_t size, size_t alignment = MemoryArena::MinBlockSize) {
+  return MemoryArena::Allocate(result, size, ArenaFlags, alignment);
+}
+
+// splitting the chunk hands out neighboring blocks, and freeing them merges the chunk back into a single block
+static void testSplitAndMerge() {
+
+  NvnMock::clearCalls();
+
+  MemoryArena::Allocation a = {}, b = {}, c = {};
+  EXPECT(allocate(&a, 0x80));
+  EXPECT(allocate(&b, MemoryArena::MinBlockSize));
+  EXPECT(allocate(&c, MemoryArena::MinBlockSize + 1));
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 1);
+
+  EXPECT(a.pool == b.pool && b.pool == c.pool);
+  EXPECT(a.offset == 0 && a.size == MemoryArena::MinBlockSize);
+  EXPECT(b.offset == (ptrdiff_t) MemoryArena::MinBlockSize);
+  EXPECT(c.offset == (ptrdiff_t) MemoryArena::MinBlockSize * 2 && c.size == MemoryArena::MinBlockSize * 2);
+  EXPECT(a.cpuPtr && b.cpuPtr == a.cpuPtr + b.offset);
+
+  // the freed block is the smallest one that fits, so it gets handed out again
+  nvn::MemoryPool *pool = a.pool;
+  ptrdiff_t freedOffset = b.offset;
+  MemoryArena::Free(b);
+  EXPECT(b.arena == nullptr);
+  EXPECT(allocate(&b, MemoryArena::MinBlockSize));
+  EXPECT(b.offset == freedOffset);
+
+  MemoryArena::Free(a);
+  MemoryArena::Free(b);
+  MemoryArena::Free(c);
+
+  // both halves of the chunk only fit if every block merged back
+  MemoryArena::Allocation first = {}, second = {};
+  EXPECT(allocate(&first, HalfChunkSize));
+  EXPECT(allocate(&second, HalfChunkSize));
+  EXPECT(first.pool == pool && second.pool == pool);
+  EXPECT(first.offset + second.offset == (ptrdiff_t) HalfChunkSize);
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 1);
+
+  MemoryArena::Free(first);
+  MemoryArena::Free(second);
+}
+
+static void testAlignment() {
+
+  NvnMock::clearCalls();
+
+  MemoryArena::Allocation small = {}, aligned = {};
+  EXPECT(allocate(&small, MemoryArena::MinBlockSize));
+  EXPECT(allocate(&aligned, MemoryArena::MinBlockSize, 0x1000));
+  EXPECT(aligned.offset % 0x1000 == 0 && aligned.offset != small.offset);
+  MemoryArena::Free(small);
+  MemoryArena::Free(aligned);
+
+  // allocations bigger than half a chunk get a dedicated pool, whose storage has to honor the alignment itself
+  MemoryArena::Allocation dedicated = {};
+  EXPECT(allocate(&dedicated, MemoryArena::ChunkSize + 1, 0x10000));
+  EXPECT(dedicated.offset == 0 && dedicated.size >= MemoryArena::ChunkSize + 1);
+  EXPECT(((uintptr_t) dedicated.cpuPtr & 0xFFFF) == 0);
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 1);
+
+  MemoryArena::Free(dedicated);
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolFinalize") == 1);
+}
+
+// empty chunks get released, except for the last regular one
+static void testChunkRelease() {
+
+  NvnMock::clearCalls();
+
+  MemoryArena::Allocation first = {}, second = {}, third = {};
+  EXPECT(allocate(&first, HalfChunkSize));
+  EXPECT(allocate(&second, HalfChunkSize));
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 0);
+
+  EXPECT(allocate(&third, HalfChunkSize));
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 1);
+  EXPECT(third.pool != first.pool);
+
+  MemoryArena::Free(third);
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolFinalize") == 1);
+
+  MemoryArena::Free(first);
+  MemoryArena::Free(second);
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolFinalize") == 1);
+
+  // the chunk that was kept serves the next allocation
+  EXPECT(allocate(&first, MemoryArena::MinBlockSize));
+  EXPECT(NvnMock::getCallCount("nvnMemoryPoolInitialize") == 1);
+  MemoryArena::Free(first);
+}
+
+int main() {
+
+  if (!HostTest::setupBackend()) {
+    return 1;
+  }
+
+  NvnMock::setRecording(true);
+
+  testSplitAndMerge();
+  testAlignment();
+  testChunkRelease();
+
+  HostTest::finish();
+}
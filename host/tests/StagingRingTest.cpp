@@ -0,0 +1,160 @@
+// Overflows the staging ring with texture updates against the mock NVN driver, whose command buffers run their texel
+// copies once submitted like the GPU would, and checks that the updates land in the texture in the order they were
+// made: an update that doesn't fit in the ring must not get overwritten by the copy of one queued before it.
+//
+// usage: imgui_xeno_staging_ring_test
+
+#include "NvnMock.h"
+#include "TestSupport.h"
+#include "imgui_backend/imgui_impl_nvn.hpp"
+#include "imgui_xeno.h"
+#include <cstring>
+#include <vector>
+
+static ImguiXenoTexture __frameTexture = 0;
+
+// a row of texels is a KiB, so the texture is twice the size of the ring
+static constexpr int TextureWidth = 256;
+static constexpr int TextureHeight = (int) (ImguiNvnBackend::StagingSize / (TextureWidth * 4)) * 2;
+
+static constexpr u8 FirstValue = 0xAA;
+static constexpr u8 SecondValue = 0x55;
+
+
+// records and submits a frame, which copies the updates staged so far into their texture
+static void renderFrame() {
+
+  ImGuiIO &io = ImGui::GetIO();
+  io.DisplaySize = ImVec2(1280.0f, 720.0f);
+  io.DeltaTime = 1.0f / 60.0f;
+
+  ImGui::NewFrame();
+  ImGui::GetForegroundDrawList()->AddImage((ImTextureID) (intptr_t) imgui_xeno_get_texture_id(__frameTexture),
+                                           ImVec2(0.0f, 0.0f), ImVec2(64.0f, 64.0f));
+  ImGui::Render();
+
+  ImguiNvnBackend::renderDrawData(ImGui::GetDrawData());
+}
+
+// whether every texel of rows [startRow, endRow) has the given value in each of its bytes
+static bool areRowsFilled(const nvn::Texture *texture, int startRow, int endRow, u8 value) {
+
+  const u8 *texels = NvnMock::getTexels(texture);
+  for (size_t i = (size_t) startRow * TextureWidth * 4; i < (size_t) endRow * TextureWidth * 4; i++) {
+    if (texels[i] != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the second update overlaps the first one, which is still queued in the ring and leaves no room for it
+static void testUserTextureOverflow() {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  std::vector<u8> zeroes((size_t) TextureWidth * TextureHeight * 4, 0);
+  ImguiXenoTexture texture = imgui_xeno_create_texture(TextureWidth, TextureHeight, IMGUI_XENO_TEXTURE_RGBA8,
+                                                       zeroes.data());
+  EXPECT(texture != 0);
+  if (!texture) {
+    return;
+  }
+  const nvn::Texture *nvnTexture = &bd->userTextures[(texture & 0xFFFF) - 1].texture;
+  renderFrame();
+  ImguiNvnBackend::waitForFrames();
+
+  // together they take more than the whole ring
+  int firstRows = TextureHeight * 3 / 8;
+  int secondRows = TextureHeight / 4;
+  std::vector<u8> first((size_t) TextureWidth * firstRows * 4, FirstValue);
+  std::vector<u8> second((size_t) TextureWidth * secondRows * 4, SecondValue);
+
+  int overflows = bd->stagingRing.overflows;
+  EXPECT(imgui_xeno_update_texture(texture, 0, 0, TextureWidth, firstRows, first.data(), 0));
+
+  // the first update holds the ring until the frame copying it is done, the second one gets retried until then
+  int frames = 0;
+  bool isUpdated = false;
+  while (!(isUpdated = imgui_xeno_update_texture(texture, 0, 0, TextureWidth, secondRows, second.data(), 0)) &&
+         frames <= ImguiNvnBackend::FramesInFlight) {
+    renderFrame();
+    frames++;
+  }
+  EXPECT(isUpdated);
+  EXPECT(bd->stagingRing.overflows > overflows);
+  renderFrame();
+
+  EXPECT(areRowsFilled(nvnTexture, 0, secondRows, SecondValue));
+  EXPECT(areRowsFilled(nvnTexture, secondRows, firstRows, FirstValue));
+  EXPECT(areRowsFilled(nvnTexture, firstRows, TextureHeight, 0));
+
+  // an update bigger than the ring can never fit, and leaves the texture as it was
+  EXPECT(!imgui_xeno_update_texture(texture, 0, 0, TextureWidth, TextureHeight, zeroes.data(), 0));
+  renderFrame();
+  EXPECT(areRowsFilled(nvnTexture, 0, secondRows, SecondValue));
+
+  imgui_xeno_destroy_texture(texture);
+}
+
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+static void updateTexture(ImTextureData &tex, ImDrawData &drawData, int rows, u8 value) {
+  memset(tex.Pixels, value, (size_t) tex.GetPitch() * rows);
+  tex.Updates.push_back({0, 0, (unsigned short) tex.Width, (unsigned short) rows});
+  tex.SetStatus(ImTextureStatus_WantUpdates);
+  ImguiNvnBackend::updateTextures(&drawData);
+  tex.Updates.resize(0);
+}
+
+// ImGui's textures can't fail their updates, so the one that doesn't fit is written directly, after the ones queued
+// before it
+static void testManagedTextureOverflow() {
+
+  ImTextureData tex;
+  tex.Create(ImTextureFormat_RGBA32, TextureWidth, TextureHeight);
+
+  ImVector<ImTextureData *> textures;
+  textures.push_back(&tex);
+  ImDrawData drawData;
+  drawData.Textures = &textures;
+
+  ImguiNvnBackend::updateTextures(&drawData);
+  EXPECT(tex.Status == ImTextureStatus_OK);
+  if (tex.Status != ImTextureStatus_OK) {
+    return;
+  }
+  const nvn::Texture *nvnTexture = &((ImguiNvnBackend::ManagedTexture *) tex.BackendUserData)->texture;
+  renderFrame();
+  ImguiNvnBackend::waitForFrames();
+
+  int overflows = ImguiNvnBackend::getBackendData()->stagingRing.overflows;
+  int firstRows = TextureHeight * 3 / 8;
+  int secondRows = TextureHeight / 4;
+  updateTexture(tex, drawData, firstRows, FirstValue);
+  updateTexture(tex, drawData, secondRows, SecondValue);
+  EXPECT(ImguiNvnBackend::getBackendData()->stagingRing.overflows > overflows);
+  renderFrame();
+
+  EXPECT(areRowsFilled(nvnTexture, 0, secondRows, SecondValue));
+  EXPECT(areRowsFilled(nvnTexture, secondRows, firstRows, FirstValue));
+  EXPECT(areRowsFilled(nvnTexture, firstRows, TextureHeight, 0));
+}
+#endif
+
+int main() {
+
+  if (!HostTest::setupBackend()) {
+    return 1;
+  }
+
+  // frames draw a texture of their own, as the font's might only get created by ImGui 1.92's texture updates
+  __frameTexture = imgui_xeno_create_texture(4, 4, IMGUI_XENO_TEXTURE_RGBA8, nullptr);
+  EXPECT(__frameTexture != 0);
+
+  testUserTextureOverflow();
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+  testManagedTextureOverflow();
+#endif
+
+  HostTest::finish();
+}
@@ -0,0 +1,113 @@
+// Records frames of draw data against the mock NVN driver, and checks that their vertices and indices end up in the
+// stream buffers of the frame's ring slot, and that those buffers only get created when a frame outgrows them.
+//
+// usage: imgui_xeno_stream_buffer_test
+
+#include "NvnMock.h"
+#include "TestSupport.h"
+#include "imgui_backend/imgui_impl_nvn.hpp"
+#include "imgui_xeno.h"
+#include <cstring>
+
+static constexpr int SmallQuadCount = 64;
+static constexpr int BigQuadCount = 4096;
+
+// the ring slot renderDrawData recorded the last frame into
+static ImguiNvnBackend::FrameResources &getRecordedFrame() {
+  auto bd = ImguiNvnBackend::getBackendData();
+  return bd->frames[(bd->frameIndex + ImguiNvnBackend::FramesInFlight - 1) % ImguiNvnBackend::FramesInFlight];
+}
+
+// whether the recorded frame's stream buffers hold the list's geometry, as it was the only one drawn
+static bool isListUploaded(const ImDrawList *cmdList) {
+
+  auto &frame = getRecordedFrame();
+  size_t vtxSize = cmdList->VtxBuffer.size_in_bytes();
+  size_t idxSize = cmdList->IdxBuffer.size_in_bytes();
+
+  return frame.vtxBuffer.memory->GetPoolSize() >= vtxSize && frame.idxBuffer.memory->GetPoolSize() >= idxSize &&
+         memcmp(frame.vtxBuffer.memory->GetMemPtr(), cmdList->VtxBuffer.Data, vtxSize) == 0 &&
+         memcmp(frame.idxBuffer.memory->GetMemPtr(), cmdList->IdxBuffer.Data, idxSize) == 0;
+}
+
+static void testUploadAndGrowth(nvn::TextureHandle texture) {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  auto smallData = HostTest::makeQuadCapture(SmallQuadCount, texture);
+  auto bigData = HostTest::makeQuadCapture(BigQuadCount, texture);
+
+  DrawDataCapture::Capture small = {}, big = {};
+  EXPECT(DrawDataCapture::read(smallData.data(), smallData.size(), small));
+  EXPECT(DrawDataCapture::read(bigData.data(), bigData.size(), big));
+  if (small.lists.empty() || big.lists.empty()) {
+    DrawDataCapture::release(small);
+    DrawDataCapture::release(big);
+    return;
+  }
+
+  // every slot of the ring creates its buffers the first time it records a frame
+  int allocations = bd->vtxStats.allocations;
+  for (int i = 0; i < ImguiNvnBackend::FramesInFlight; i++) {
+    HostTest::renderFrame(&small.drawData);
+  }
+  EXPECT(bd->vtxStats.allocations == allocations + ImguiNvnBackend::FramesInFlight);
+
+  // then frames that fit don't create any
+  NvnMock::setRecording(true);
+  NvnMock::clearCalls();
+  allocations = bd->vtxStats.allocations;
+  for (int i = 0; i < ImguiNvnBackend::FramesInFlight; i++) {
+    HostTest::renderFrame(&small.drawData);
+  }
+  EXPECT(bd->vtxStats.allocations == allocations);
+  EXPECT(NvnMock::getCallCount("nvnBufferInitialize") == 0);
+  EXPECT(NvnMock::getCallCount("nvnCommandBufferBindVertexBuffer") == ImguiNvnBackend::FramesInFlight);
+  EXPECT(NvnMock::getCallCount("nvnQueueSubmitCommands") == ImguiNvnBackend::FramesInFlight);
+  EXPECT(isListUploaded(small.lists[0]));
+
+  // a frame that doesn't fit gets new vertex and index buffers
+  NvnMock::clearCalls();
+  HostTest::renderFrame(&big.drawData);
+  EXPECT(bd->vtxStats.allocations == allocations + 1);
+  EXPECT(bd->idxStats.highWaterMark == (size_t) big.lists[0]->IdxBuffer.size_in_bytes());
+  EXPECT(NvnMock::getCallCount("nvnBufferInitialize") >= 2);
+  EXPECT(isListUploaded(big.lists[0]));
+
+  // the other slots grow once too, after which the ring fits the big frame everywhere
+  for (int i = 1; i < ImguiNvnBackend::FramesInFlight; i++) {
+    HostTest::renderFrame(&big.drawData);
+  }
+  EXPECT(bd->vtxStats.allocations == allocations + ImguiNvnBackend::FramesInFlight);
+
+  NvnMock::clearCalls();
+  allocations = bd->vtxStats.allocations;
+  for (int i = 0; i < ImguiNvnBackend::FramesInFlight; i++) {
+    HostTest::renderFrame(&big.drawData);
+    EXPECT(isListUploaded(big.lists[0]));
+    HostTest::renderFrame(&small.drawData);
+    EXPECT(isListUploaded(small.lists[0]));
+  }
+  EXPECT(bd->vtxStats.allocations == allocations);
+  EXPECT(NvnMock::getCallCount("nvnBufferInitialize") == 0);
+
+  NvnMock::setRecording(false);
+
+  DrawDataCapture::release(small);
+  DrawDataCapture::release(big);
+}
+
+int main() {
+
+  if (!HostTest::setupBackend()) {
+    return 1;
+  }
+
+  ImguiXenoTexture texture = imgui_xeno_create_texture(4, 4, IMGUI_XENO_TEXTURE_RGBA8, nullptr);
+  EXPECT(texture != 0);
+  if (texture) {
+    testUploadAndGrowth(*(const nvn::TextureHandle *) imgui_xeno_get_texture_id(texture));
+  }
+
+  HostTest::finish();
+}
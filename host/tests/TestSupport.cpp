@@ -0,0 +1,122 @@
+#include "TestSupport.h"
+#include "NvnMock.h"
+#include "imgui_backend/imgui_impl_nvn.hpp"
+#include "imgui_backend/imgui_nvn.h"
+#include "imgui_xeno.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static nvn::Device __device;
+static nvn::Queue __queue;
+static int __failures = 0;
+
+template <typename T>
+static void append(std::vector<u8> &out, const T *data, size_t count) {
+  size_t offset = out.size();
+  out.resize(offset + sizeof(T) * count);
+  memcpy(out.data() + offset, data, sizeof(T) * count);
+}
+
+void HostTest::fail(const char *file, int line, const char *cond) {
+  printf("%s:%d: expected %s\n", file, line, cond);
+  __failures++;
+}
+
+bool HostTest::setupBackend() {
+
+  auto getProcAddress = (nvn::DeviceGetProcAddressFunc) imgui_xeno_bootstrap_hook("nvnDeviceGetProcAddress",
+                                                                                  NvnMock::bootstrapLoader);
+  auto deviceInit = (nvn::DeviceInitializeFunc) imgui_xeno_bootstrap_hook("nvnDeviceInitialize",
+                                                                          NvnMock::bootstrapLoader);
+
+  nvn::DeviceBuilder deviceBuilder = {};
+  deviceInit(&__device, &deviceBuilder);
+
+  auto queueInit = (nvn::QueueInitializeFunc) getProcAddress(&__device, "nvnQueueInitialize");
+  nvn::QueueBuilder queueBuilder = {};
+  queueInit(&__queue, &queueBuilder);
+
+  NvnMock::setRecording(false);
+
+  if (!nvnImGui::InitImGui() || !ImguiNvnBackend::getBackendData()->isInitialized) {
+    printf("Failed to set up the backend!\n");
+    return false;
+  }
+
+  return true;
+}
+
+void HostTest::finish() {
+
+  if (__failures > 0) {
+    printf("%d checks failed\n", __failures);
+  } else {
+    printf("All checks passed\n");
+  }
+
+  fflush(stdout);
+  _Exit(__failures > 0 ? 1 : 0);
+}
+
+std::vector<u8> HostTest::makeQuadCapture(int quadCount, nvn::TextureHandle texture) {
+
+  DrawDataCapture::Header header = {
+      .magic = DrawDataCapture::Magic,
+      .version = DrawDataCapture::Version,
+      .vtxStride = sizeof(ImDrawVert),
+      .idxStride = sizeof(ImDrawIdx),
+      .displayPos = ImVec2(0.0f, 0.0f),
+      .displaySize = ImVec2(1280.0f, 720.0f),
+      .framebufferScale = ImVec2(1.0f, 1.0f),
+      .listCount = 1,
+      .totalVtxCount = quadCount * 4,
+      .totalIdxCount = quadCount * 6,
+      .totalCmdCount = 1
+  };
+
+  DrawDataCapture::ListHeader listHeader = {
+      .vtxCount = quadCount * 4,
+      .idxCount = quadCount * 6,
+      .cmdCount = 1,
+      .flags = 0
+  };
+
+  std::vector<u8> out;
+  append(out, &header, 1);
+  append(out, &listHeader, 1);
+
+  // 8x8 quads in rows across the display, each with a color of its own so uploads can be told apart
+  for (int i = 0; i < quadCount; i++) {
+    float x = (float) (i % 160) * 8.0f, y = (float) (i / 160 % 90) * 8.0f;
+    ImU32 col = 0xFF000000 | (ImU32) i;
+    const ImDrawVert vertices[4] = {
+        {ImVec2(x, y), ImVec2(0.0f, 0.0f), col},
+        {ImVec2(x + 8.0f, y), ImVec2(1.0f, 0.0f), col},
+        {ImVec2(x + 8.0f, y + 8.0f), ImVec2(1.0f, 1.0f), col},
+        {ImVec2(x, y + 8.0f), ImVec2(0.0f, 1.0f), col},
+    };
+    append(out, vertices, 4);
+  }
+
+  for (int i = 0; i < quadCount; i++) {
+    auto base = (ImDrawIdx) (i * 4);
+    const ImDrawIdx indices[6] = {base, (ImDrawIdx) (base + 1), (ImDrawIdx) (base + 2), base,
+                                  (ImDrawIdx) (base + 2), (ImDrawIdx) (base + 3)};
+    append(out, indices, 6);
+  }
+
+  DrawDataCapture::CmdData cmdData;
+  memset((void *) &cmdData, 0, sizeof(cmdData));
+  cmdData.clipRect = ImVec4(0.0f, 0.0f, 1280.0f, 720.0f);
+  cmdData.texture = texture;
+  cmdData.elemCount = (u32) quadCount * 6;
+  append(out, &cmdData, 1);
+
+  return out;
+}
+
+void HostTest::renderFrame(ImDrawData *drawData) {
+  ImguiNvnBackend::invalidateRecordedFrame();
+  ImguiNvnBackend::renderDrawData(drawData);
+}
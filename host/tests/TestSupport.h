@@ -0,0 +1,36 @@
+#pragma once
+
+#include "imgui_backend/DrawDataCapture.h"
+#include "nvn_Cpp.h"
+#include "types.h"
+#include <vector>
+
+// checks a condition, reporting where it failed. a test keeps going after a failed check, and exits with a failure
+// once it calls HostTest::finish
+#define EXPECT(cond)                                                                                                  \
+  do {                                                                                                                \
+    if (!(cond)) {                                                                                                    \
+      HostTest::fail(__FILE__, __LINE__, #cond);                                                                      \
+    }                                                                                                                 \
+  } while (false)
+
+// shared by the tests in host/tests, which each run the backend (or part of it) against the mocks
+namespace HostTest {
+
+  void fail(const char *file, int line, const char *cond);
+
+  // goes through the same hooks a game would, then sets up ImGui and the backend on the mock device. the mock NVN
+  // driver doesn't record calls until a test enables it
+  bool setupBackend();
+
+  // the backend has no shutdown, its worker threads (async frames, panels) keep waiting on the mock's objects until
+  // the process ends. running the static destructors would tear those down under them, so this leaves without
+  [[noreturn]] void finish();
+
+  // a capture of a single draw list, holding quadCount quads drawn with the given texture in one command
+  std::vector<u8> makeQuadCapture(int quadCount, nvn::TextureHandle texture);
+
+  // records and submits the draw data, even if it didn't change since the last frame
+  // (see IMGUI_XENO_REPLAY_UNCHANGED_FRAMES)
+  void renderFrame(ImDrawData *drawData);
+}
@@ -15,6 +15,17 @@
  */
 extern "C" void imgui_xeno_init(InitFunc init, ProcDrawFunc renderCallback);
 
+/**
+ * Registers a panel: a draw callback that doesn't depend on any other callback, so it can be built on a worker thread.
+ *
+ * Each panel gets an ImGui context of its own, sharing the fonts and style of the main one, and is drawn on top of
+ * the main context's windows. Input goes to the context under the mouse. If `IMGUI_XENO_PANEL_THREADS` is 0, the
+ * panel runs as a regular draw callback instead.
+ *
+ * @param renderCallback the function building the panel every UI update
+ */
+extern "C" void imgui_xeno_add_panel(ProcDrawFunc renderCallback);
+
 /**
  * The function to call when `nvnBootstrapLoader` is being called by the game.
  *
@@ -41,4 +52,106 @@ extern "C" void* imgui_xeno_bootstrap_hook(const char *functionName, OrigNvnBoot
  *
  * @param loggerCallback the external logger function
  */
-extern "C" void imgui_xeno_set_logger(LoggerFunc loggerCallback);
\ No newline at end of file
+extern "C" void imgui_xeno_set_logger(LoggerFunc loggerCallback);
+
+/**
+ * Changes how many times per second the UI is updated (see `IMGUI_XENO_UPDATE_RATE`).
+ *
+ * Draw callbacks only run on updates. In between, the last frame keeps being drawn. While the user is interacting with
+ * the overlay, it is updated every frame regardless of the rate.
+ *
+ * @param rate updates per second. 0 updates every frame, and a negative rate only updates on input or when
+ *             `imgui_xeno_request_update` is called
+ */
+extern "C" void imgui_xeno_set_update_rate(float rate);
+
+/**
+ * Requests a UI update on the next frame, even if the update rate would skip it. Useful to show data that changed
+ * while the UI is throttled.
+ */
+extern "C" void imgui_xeno_request_update();
+
+/**
+ * Sets the time budget of each draw callback. Callbacks that keep running over it get demoted to a lower update rate,
+ * their windows being redrawn from their last run in between. Demotions are logged. Needs ImGui 1.89.8 or newer,
+ * callbacks are only timed with older versions.
+ *
+ * @param budgetMs budget in milliseconds, 0 to disable it (demoted callbacks then return to running every update)
+ */
+extern "C" void imgui_xeno_set_callback_budget(float budgetMs);
+
+/**
+ * Copies the timings and draw counts of the overlay's last frame.
+ *
+ * CPU times are measured with the system tick. The GPU time comes from timestamps written around the overlay's
+ * commands, which are only read back once the GPU is done with them, so it lags a few frames behind.
+ *
+ * Meant to be called from draw callbacks. With IMGUI_XENO_ASYNC_FRAMES, they get the stats as of the moment the worker
+ * started building the current frame.
+ *
+ * @param stats the struct to fill
+ */
+extern "C" void imgui_xeno_get_frame_stats(ImguiXenoFrameStats *stats);
+
+/**
+ * Dumps the draw data of the next frame (every draw list, with its vertices, indices, clip rects and textures) to a
+ * binary capture file. Captures can be replayed and profiled offline with the host benchmark (`imgui_xeno_bench`).
+ *
+ * If `IMGUI_XENO_CAPTURE_HOTKEY` is enabled, pressing Minus while holding ZL + ZR does the same.
+ *
+ * @param path the file to write, or `nullptr` for a new file in `IMGUI_XENO_CAPTURE_PATH`
+ */
+extern "C" void imgui_xeno_capture_frame(const char *path);
+
+/**
+ * Creates a texture that can be drawn with `ImGui::Image` and the like, using the ID from `imgui_xeno_get_texture_id`.
+ *
+ * Textures get a descriptor slot of their own, out of the backend's pools, which goes back to a free list once the
+ * texture is destroyed. Up to `IMGUI_XENO_MAX_USER_TEXTURES` textures can exist at once.
+ *
+ * Can be called from the init callback, draw callbacks or any other thread once the backend is initialized, but not
+ * from panels.
+ *
+ * @param width width in pixels, a multiple of 4 for BC formats
+ * @param height height in pixels, a multiple of 4 for BC formats
+ * @param format the format of the texture and of data
+ * @param data tightly packed texels to initialize the texture with, or `nullptr` to leave it uninitialized
+ * @returns the texture, or 0 if it couldn't be created
+ */
+extern "C" ImguiXenoTexture imgui_xeno_create_texture(int width, int height, ImguiXenoTextureFormat format,
+                                                      const void *data);
+
+/**
+ * Writes texels to a region of a texture. They are copied to the staging ring (see `IMGUI_XENO_STAGING_SIZE`), and the
+ * GPU copies them into the texture before the next frame draws, so neither side waits on the other and frames already
+ * in flight keep sampling the previous texels. Updates that don't fit in the ring fail and leave the texture as it was:
+ * retry them once a frame has been drawn, and split the ones bigger than the ring into several regions.
+ *
+ * @param texture the texture to update
+ * @param x left of the region, a multiple of 4 for BC formats (as are the other coordinates)
+ * @param y top of the region
+ * @param width width of the region
+ * @param height height of the region
+ * @param data the texels of the region
+ * @param pitch bytes between two rows of data (rows of blocks for BC formats), 0 if they are tightly packed
+ * @returns whether the texture was updated, false if the ring was full
+ */
+extern "C" bool imgui_xeno_update_texture(ImguiXenoTexture texture, int x, int y, int width, int height,
+                                          const void *data, int pitch);
+
+/**
+ * Destroys a texture. Its memory and descriptor slot are only freed once the GPU is done with every frame that drew
+ * it, so it can be destroyed while it is still in use (the handle becomes invalid right away).
+ *
+ * @param texture the texture to destroy
+ */
+extern "C" void imgui_xeno_destroy_texture(ImguiXenoTexture texture);
+
+/**
+ * Returns the texture ID to give ImGui to draw a texture, cast with `(ImTextureID) (intptr_t)`. The ID stays the same
+ * for the texture's whole life.
+ *
+ * @param texture the texture to draw
+ * @returns the texture ID, or `nullptr` if the texture doesn't exist
+ */
+extern "C" void *imgui_xeno_get_texture_id(ImguiXenoTexture texture);
\ No newline at end of file
@@ -5,4 +5,49 @@
 typedef void (*ProcDrawFunc)();
 typedef void (*InitFunc)();
 typedef void* (*OrigNvnBootstrap)(const char*);
-typedef void (*LoggerFunc)(const char*, size_t);
\ No newline at end of file
+typedef void (*LoggerFunc)(const char*, size_t);
+
+#define IMGUI_XENO_MAX_CALLBACK_STATS 16
+
+// texture registered with imgui_xeno_create_texture, 0 is never a valid texture
+typedef unsigned int ImguiXenoTexture;
+
+typedef enum {
+  IMGUI_XENO_TEXTURE_RGBA8,
+  // block compressed formats, their data is laid out in rows of 4x4 blocks
+  IMGUI_XENO_TEXTURE_BC1,
+  IMGUI_XENO_TEXTURE_BC3,
+  IMGUI_XENO_TEXTURE_BC7,
+} ImguiXenoTextureFormat;
+
+typedef struct {
+  // CPU times of the last UI update, in milliseconds
+  float newFrameMs;
+  float callbacksMs;
+  float renderMs;
+  // last measured time of each draw callback, in registration order
+  int callbackCount;
+  float callbackMs[IMGUI_XENO_MAX_CALLBACK_STATS];
+  // how many updates each draw callback runs on, 1 unless it got demoted for running over budget
+  int callbackInterval[IMGUI_XENO_MAX_CALLBACK_STATS];
+  // time each panel took on its worker thread, and how long the UI update then waited for the panels to finish
+  int panelCount;
+  float panelMs[IMGUI_XENO_MAX_CALLBACK_STATS];
+  float panelWaitMs;
+
+  // CPU time spent recording and submitting the overlay's commands in the last frame
+  float recordMs;
+  // GPU time of the overlay's commands, read back once the GPU is done with them (a few frames late)
+  float gpuMs;
+
+  // the last frame resubmitted the recording of an unchanged one (see IMGUI_XENO_REPLAY_UNCHANGED_FRAMES). nothing got
+  // recorded then, so the command, draw and bind counts are 0
+  bool replayed;
+  // ImDrawCmds in the last frame, and the draws they were merged into
+  int cmdCount;
+  int drawCount;
+  int vtxCount;
+  int idxCount;
+  // viewport, scissor, texture, vertex buffer and blend state binds skipped as they were already set
+  int skippedBindCount;
+} ImguiXenoFrameStats;
\ No newline at end of file
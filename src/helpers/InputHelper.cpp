@@ -1,5 +1,6 @@
 #include "InputHelper.h"
 #include "logger/Logger.hpp"
+#include <cstring>
 
 nn::hid::NpadBaseState InputHelper::prevControllerState{};
 nn::hid::NpadBaseState InputHelper::curControllerState{};
@@ -129,4 +130,28 @@ bool InputHelper::isTouchPress() {
 
 bool InputHelper::isTouchRelease() {
   return curTouchState.count < 1 && prevTouchState.count >= 1;
-}
\ No newline at end of file
+}
+
+bool InputHelper::isInputActive() {
+  static const decltype(curControllerState.mButtons) noButtons{};
+  static const decltype(curKeyboardState.keys) noKeys{};
+  static const decltype(curMouseState.buttons) noMouseButtons{};
+
+  // the pad only drives ImGui while input is toggled, but the toggle combo itself should always count
+  bool isPadActive = memcmp(&curControllerState.mButtons, &prevControllerState.mButtons, sizeof(noButtons)) != 0 ||
+                     (toggleInput && (memcmp(&curControllerState.mButtons, &noButtons, sizeof(noButtons)) != 0 ||
+                                      getLeftStickX() * getLeftStickX() + getLeftStickY() * getLeftStickY() > 0.04f ||
+                                      getRightStickX() * getRightStickX() + getRightStickY() * getRightStickY() > 0.04f));
+
+  bool isKeyboardActive = memcmp(&curKeyboardState.keys, &noKeys, sizeof(noKeys)) != 0 ||
+                          memcmp(&prevKeyboardState.keys, &noKeys, sizeof(noKeys)) != 0;
+
+  bool isMouseActive = curMouseState.x != prevMouseState.x || curMouseState.y != prevMouseState.y ||
+                       curMouseState.wheelDeltaX != 0 || curMouseState.wheelDeltaY != 0 ||
+                       memcmp(&curMouseState.buttons, &noMouseButtons, sizeof(noMouseButtons)) != 0 ||
+                       memcmp(&prevMouseState.buttons, &noMouseButtons, sizeof(noMouseButtons)) != 0;
+
+  bool isTouchActive = curTouchState.count > 0 || prevTouchState.count > 0;
+
+  return isPadActive || isKeyboardActive || isMouseActive || isTouchActive;
+}
@@ -9,6 +9,9 @@ class InputHelper {
 public:
   static void updatePadState();
 
+  // true if any input changed since the last update, or a button/key/touch is still being held
+  static bool isInputActive();
+
   static void setPort(ulong port) { selectedPort = port; }
 
   static void initKBM();
@@ -1,4 +1,5 @@
 #include "memoryHelper.h"
+#include <cstring>
 
 // Need a function to act as the default value
 inline void catch_all() { XENO_ABORT("Memory not yet loaded");
@@ -42,4 +43,36 @@ void Mem::Deallocate(void *ptr) {
 
 void* Mem::Reallocate(void *ptr, size_t new_size) {
   return (Realloc)(ptr, new_size);
-}
\ No newline at end of file
+}
+
+void Mem::CopyNonTemporal(void *dst, const void *src, size_t size) {
+#ifdef __aarch64__
+  auto *d = (u8 *) dst;
+  auto *s = (const u8 *) src;
+
+  // copy the unaligned head normally, so the bulk loop stores to 16 byte aligned addresses
+  size_t head = ALIGN_UP(d, 16) - (uintptr_t) d;
+  if (head > size) {
+    head = size;
+  }
+  memcpy(d, s, head);
+  d += head;
+  s += head;
+  size -= head;
+
+  for (; size >= 64; size -= 64, d += 64, s += 64) {
+    asm volatile(
+        "ldp q0, q1, [%[src]]\n"
+        "ldp q2, q3, [%[src], #32]\n"
+        "stnp q0, q1, [%[dst]]\n"
+        "stnp q2, q3, [%[dst], #32]\n"
+        :
+        : [dst] "r"(d), [src] "r"(s)
+        : "v0", "v1", "v2", "v3", "memory");
+  }
+
+  memcpy(d, s, size);
+#else
+  memcpy(dst, src, size);
+#endif
+}
@@ -20,6 +20,10 @@ namespace Mem {
   void Deallocate(void *ptr);
 
   void* Reallocate(void *ptr, size_t new_size);
+
+  // bulk copy using non-temporal stores in 64 byte blocks, meant for write-combined (CPU_UNCACHED) GPU memory.
+  // falls back to memcpy on other architectures
+  void CopyNonTemporal(void *dst, const void *src, size_t size);
 }
 
 
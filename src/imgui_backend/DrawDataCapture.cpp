@@ -0,0 +1,257 @@
+#include "DrawDataCapture.h"
+#include "imgui_impl_nvn.hpp"
+#include "logger/Logger.hpp"
+#include <cstring>
+
+namespace DrawDataCapture {
+
+  template <typename T>
+  static void append(ImVector<u8> &out, const T *data, size_t count) {
+    size_t size = sizeof(T) * count;
+    int offset = out.Size;
+    out.resize(offset + (int) size);
+    memcpy(out.Data + offset, data, size);
+  }
+
+  // reads count elements and advances the cursor, fails instead of reading past the end
+  template <typename T>
+  static bool consume(const u8 *&cursor, const u8 *end, T *out, size_t count) {
+    size_t size = sizeof(T) * count;
+    if ((size_t) (end - cursor) < size) {
+      return false;
+    }
+    memcpy(out, cursor, size);
+    cursor += size;
+    return true;
+  }
+
+  // whether every index of the command addresses a vertex of the list, once offset by the command's vtxOffset
+  static bool areIndicesInRange(const ImDrawList *cmdList, const CmdData &cmdData, int vtxCount) {
+
+    if (cmdData.vtxOffset >= (u32) vtxCount) {
+      return false;
+    }
+
+    ImDrawIdx maxIdx = 0;
+    const ImDrawIdx *indices = cmdList->IdxBuffer.Data + cmdData.idxOffset;
+    for (u32 i = 0; i < cmdData.elemCount; i++) {
+      maxIdx = indices[i] > maxIdx ? indices[i] : maxIdx;
+    }
+
+    return (size_t) cmdData.vtxOffset + maxIdx < (size_t) vtxCount;
+  }
+
+  size_t getCaptureSize(const ImDrawData *drawData) {
+
+    size_t size = sizeof(Header);
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+      auto cmdList = drawData->CmdLists[i];
+      size += sizeof(ListHeader) + cmdList->VtxBuffer.size_in_bytes() + cmdList->IdxBuffer.size_in_bytes() +
+              cmdList->CmdBuffer.Size * sizeof(CmdData);
+    }
+
+    return size;
+  }
+
+  bool write(const ImDrawData *drawData, ImVector<u8> &out) {
+
+    Header header = {
+        .magic = Magic,
+        .version = Version,
+        .vtxStride = sizeof(ImDrawVert),
+        .idxStride = sizeof(ImDrawIdx),
+        .displayPos = drawData->DisplayPos,
+        .displaySize = drawData->DisplaySize,
+        .framebufferScale = drawData->FramebufferScale,
+        .listCount = drawData->CmdListsCount,
+        .totalVtxCount = drawData->TotalVtxCount,
+        .totalIdxCount = drawData->TotalIdxCount,
+        .totalCmdCount = 0
+    };
+
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+      header.totalCmdCount += drawData->CmdLists[i]->CmdBuffer.Size;
+    }
+
+    out.reserve(out.Size + (int) getCaptureSize(drawData));
+    append(out, &header, 1);
+
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+      auto cmdList = drawData->CmdLists[i];
+
+      ListHeader listHeader = {
+          .vtxCount = cmdList->VtxBuffer.Size,
+          .idxCount = cmdList->IdxBuffer.Size,
+          .cmdCount = cmdList->CmdBuffer.Size,
+          .flags = (u32) cmdList->Flags
+      };
+
+      append(out, &listHeader, 1);
+      append(out, cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size);
+      append(out, cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size);
+
+      for (auto &cmd: cmdList->CmdBuffer) {
+        if (cmd.UserCallback) {
+          Logger::log("Cannot Capture Draw Data with User Callbacks!\n");
+          return false;
+        }
+
+        // e.g. textures ImGui created, but the backend hasn't yet (see updateTextures)
+        if (!cmd.GetTexID()) {
+          Logger::log("Cannot Capture Draw Data with Commands Missing a Texture!\n");
+          return false;
+        }
+
+        // zeroed first, so the struct's padding is written out deterministically
+        CmdData cmdData;
+        memset((void *) &cmdData, 0, sizeof(CmdData));
+        cmdData.clipRect = cmd.ClipRect;
+        cmdData.texture = *(nvn::TextureHandle *) cmd.GetTexID();
+        cmdData.vtxOffset = cmd.VtxOffset;
+        cmdData.idxOffset = cmd.IdxOffset;
+        cmdData.elemCount = cmd.ElemCount;
+        append(out, &cmdData, 1);
+      }
+    }
+
+    return true;
+  }
+
+  bool read(const void *data, size_t size, Capture &capture) {
+
+    auto cursor = (const u8 *) data;
+    auto end = cursor + size;
+
+    Header header = {};
+    if (!consume(cursor, end, &header, 1) || header.magic != Magic) {
+      Logger::log("Draw Data Capture is Invalid!\n");
+      return false;
+    }
+
+    if (header.version != Version || header.vtxStride != sizeof(ImDrawVert) ||
+        header.idxStride != sizeof(ImDrawIdx)) {
+      Logger::log("Draw Data Capture Format Mismatch! Version: %d Vertex Size: %d Index Size: %d\n", header.version,
+                  header.vtxStride, header.idxStride);
+      return false;
+    }
+
+    if (header.listCount < 0 || header.totalCmdCount < 0) {
+      Logger::log("Draw Data Capture is Invalid!\n");
+      return false;
+    }
+
+    // nothing gets sized from the capture before checking the data is actually there
+    if ((size_t) header.totalCmdCount > (size_t) (end - cursor) / sizeof(CmdData)) {
+      Logger::log("Draw Data Capture is Truncated!\n");
+      return false;
+    }
+
+    // sized up front, commands point into it
+    capture.textures.resize(header.totalCmdCount);
+    int textureIdx = 0;
+    // the stream buffers get sized from the totals, so they are counted here rather than trusted from the header
+    int totalVtxCount = 0;
+    int totalIdxCount = 0;
+
+    for (int i = 0; i < header.listCount; i++) {
+      ListHeader listHeader = {};
+      if (!consume(cursor, end, &listHeader, 1) || listHeader.vtxCount < 0 || listHeader.idxCount < 0 ||
+          listHeader.cmdCount < 0) {
+        Logger::log("Draw Data Capture is Truncated!\n");
+        return false;
+      }
+
+      size_t listSize = (size_t) listHeader.vtxCount * sizeof(ImDrawVert) +
+                        (size_t) listHeader.idxCount * sizeof(ImDrawIdx) +
+                        (size_t) listHeader.cmdCount * sizeof(CmdData);
+      if ((size_t) (end - cursor) < listSize) {
+        Logger::log("Draw Data Capture is Truncated!\n");
+        return false;
+      }
+
+      auto cmdList = IM_NEW(ImDrawList)(nullptr);
+      capture.lists.push_back(cmdList);
+
+      cmdList->Flags = (ImDrawListFlags) listHeader.flags;
+      cmdList->VtxBuffer.resize(listHeader.vtxCount);
+      cmdList->IdxBuffer.resize(listHeader.idxCount);
+      cmdList->CmdBuffer.resize(listHeader.cmdCount);
+
+      if (!consume(cursor, end, cmdList->VtxBuffer.Data, listHeader.vtxCount) ||
+          !consume(cursor, end, cmdList->IdxBuffer.Data, listHeader.idxCount) ||
+          textureIdx + listHeader.cmdCount > capture.textures.Size) {
+        Logger::log("Draw Data Capture is Truncated!\n");
+        return false;
+      }
+
+      for (auto &cmd: cmdList->CmdBuffer) {
+        CmdData cmdData = {};
+        if (!consume(cursor, end, &cmdData, 1)) {
+          Logger::log("Draw Data Capture is Truncated!\n");
+          return false;
+        }
+
+        // indices get copied (and rebased) per command, they must stay within the list's index buffer, and the
+        // vertices they address within its vertex buffer
+        if ((size_t) cmdData.idxOffset + cmdData.elemCount > (size_t) listHeader.idxCount ||
+            (cmdData.elemCount > 0 && !areIndicesInRange(cmdList, cmdData, listHeader.vtxCount))) {
+          Logger::log("Draw Data Capture has Out of Range Commands!\n");
+          return false;
+        }
+
+        capture.textures[textureIdx] = cmdData.texture;
+
+        cmd = ImDrawCmd();
+        cmd.ClipRect = cmdData.clipRect;
+#if IMGUI_VERSION_NUM >= 19200
+        cmd.TexRef = ImTextureRef(ImguiNvnBackend::toTexId(&capture.textures[textureIdx++]));
+#else
+        cmd.TextureId = ImguiNvnBackend::toTexId(&capture.textures[textureIdx++]);
+#endif
+        cmd.VtxOffset = cmdData.vtxOffset;
+        cmd.IdxOffset = cmdData.idxOffset;
+        cmd.ElemCount = cmdData.elemCount;
+      }
+
+      totalVtxCount += listHeader.vtxCount;
+      totalIdxCount += listHeader.idxCount;
+    }
+
+    if (totalVtxCount != header.totalVtxCount || totalIdxCount != header.totalIdxCount) {
+      Logger::log("Draw Data Capture Totals Mismatch! Vertices: %d/%d Indices: %d/%d\n", totalVtxCount,
+                  header.totalVtxCount, totalIdxCount, header.totalIdxCount);
+      return false;
+    }
+
+    ImDrawData &drawData = capture.drawData;
+    drawData.Valid = true;
+    drawData.CmdListsCount = capture.lists.Size;
+    drawData.TotalVtxCount = totalVtxCount;
+    drawData.TotalIdxCount = totalIdxCount;
+    drawData.DisplayPos = header.displayPos;
+    drawData.DisplaySize = header.displaySize;
+    drawData.FramebufferScale = header.framebufferScale;
+
+#if IMGUI_VERSION_NUM >= 18980
+    drawData.CmdLists.resize(capture.lists.Size);
+    for (int i = 0; i < capture.lists.Size; i++) {
+      drawData.CmdLists[i] = capture.lists[i];
+    }
+#else
+    drawData.CmdLists = capture.lists.Data;
+#endif
+
+    return true;
+  }
+
+  void release(Capture &capture) {
+
+    for (auto cmdList: capture.lists) {
+      IM_DELETE(cmdList);
+    }
+
+    capture.lists.clear();
+    capture.textures.clear();
+    capture.drawData.Clear();
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "imgui.h"
+#include "nvn_Cpp.h"
+#include "types.h"
+
+// serialized ImDrawData, so a frame can be replayed through renderDrawData later (e.g. by the host benchmark).
+// captures are only readable by builds using the same ImDrawVert/ImDrawIdx layout
+namespace DrawDataCapture {
+
+  static constexpr u32 Magic = 0x50414358; // "XCAP"
+  static constexpr u32 Version = 1;
+
+  struct Header {
+    u32 magic;
+    u32 version;
+    u32 vtxStride;
+    u32 idxStride;
+    ImVec2 displayPos;
+    ImVec2 displaySize;
+    ImVec2 framebufferScale;
+    s32 listCount;
+    s32 totalVtxCount;
+    s32 totalIdxCount;
+    s32 totalCmdCount;
+  };
+
+  // followed by VtxBuffer, IdxBuffer, then cmdCount CmdData
+  struct ListHeader {
+    s32 vtxCount;
+    s32 idxCount;
+    s32 cmdCount;
+    u32 flags;
+  };
+
+  // textures are stored as the handle the backend binds, user callbacks aren't supported
+  struct CmdData {
+    ImVec4 clipRect;
+    nvn::TextureHandle texture;
+    u32 vtxOffset;
+    u32 idxOffset;
+    u32 elemCount;
+  };
+
+  // a capture loaded back into draw data, owning its draw lists and the texture handles they point to
+  struct Capture {
+    ImDrawData drawData;
+    ImVector<ImDrawList *> lists;
+    ImVector<nvn::TextureHandle> textures;
+  };
+
+  size_t getCaptureSize(const ImDrawData *drawData);
+
+  // appends the serialized draw data to out
+  bool write(const ImDrawData *drawData, ImVector<u8> &out);
+
+  // release has to be called on the capture even if reading fails
+  bool read(const void *data, size_t size, Capture &capture);
+
+  void release(Capture &capture);
+}
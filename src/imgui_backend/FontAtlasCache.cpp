@@ -0,0 +1,246 @@
+#include "FontAtlasCache.h"
+#include "helpers/fsHelper.h"
+#include "helpers/memoryHelper.h"
+#include "imgui_backend_config.h"
+#include "imgui_internal.h"
+#include "logger/Logger.hpp"
+#include <cstring>
+
+#if IMGUI_XENO_FONT_CACHE && (IMGUI_VERSION_NUM < 18700 || IMGUI_VERSION_NUM >= 19200)
+#error "IMGUI_XENO_FONT_CACHE needs ImGui 1.87 to 1.91"
+#endif
+
+#if IMGUI_XENO_FONT_CACHE
+
+namespace FontAtlasCache {
+
+  template <typename T>
+  static void append(ImVector<u8> &out, const T *data, size_t count) {
+    size_t size = sizeof(T) * count;
+    int offset = out.Size;
+    out.resize(offset + (int) size);
+    memcpy(out.Data + offset, data, size);
+  }
+
+  template <typename T>
+  static bool consume(const u8 *&cursor, const u8 *end, T *out, size_t count) {
+    size_t size = sizeof(T) * count;
+    if ((size_t) (end - cursor) < size) {
+      return false;
+    }
+    memcpy(out, cursor, size);
+    cursor += size;
+    return true;
+  }
+
+  u32 getKey(ImFontAtlas *atlas, u32 texFormat) {
+
+    u32 layout[] = {IMGUI_VERSION_NUM, sizeof(ImFontGlyph), sizeof(ImFontConfig), texFormat};
+    ImGuiID key = ImHashData(layout, sizeof(layout), Version);
+
+    key = ImHashData(&atlas->Flags, sizeof(atlas->Flags), key);
+    key = ImHashData(&atlas->TexDesiredWidth, sizeof(atlas->TexDesiredWidth), key);
+    key = ImHashData(&atlas->TexGlyphPadding, sizeof(atlas->TexGlyphPadding), key);
+
+    for (auto &rect: atlas->CustomRects) {
+      key = ImHashData(&rect.Width, sizeof(rect.Width), key);
+      key = ImHashData(&rect.Height, sizeof(rect.Height), key);
+    }
+
+    for (auto &config: atlas->ConfigData) {
+      // the config is zeroed on construction, so hashing it whole is stable once its pointers are left out
+      ImFontConfig settings = config;
+      settings.FontData = nullptr;
+      settings.GlyphRanges = nullptr;
+      settings.DstFont = nullptr;
+      key = ImHashData(&settings, sizeof(settings), key);
+
+      key = ImHashData(config.FontData, config.FontDataSize, key);
+
+      for (const ImWchar *range = config.GlyphRanges; range && *range; range++) {
+        key = ImHashData(range, sizeof(*range), key);
+      }
+
+      int fontIdx = atlas->Fonts.index_from_ptr(atlas->Fonts.find(config.DstFont));
+      key = ImHashData(&fontIdx, sizeof(fontIdx), key);
+    }
+
+    return key;
+  }
+
+  // does what the atlas build does besides rasterizing: sets up the fonts, places the custom rects and builds the
+  // lookup tables from the restored glyphs
+  static bool restoreAtlas(ImFontAtlas *atlas, const Header &header, const u8 *cursor, const u8 *end) {
+
+    atlas->ClearTexData();
+    ImFontAtlasBuildInit(atlas);
+
+    if (atlas->Fonts.Size != header.fontCount || atlas->CustomRects.Size != header.customRectCount) {
+      return false;
+    }
+
+    for (auto font: atlas->Fonts) {
+      FontData fontData = {};
+      if (!consume(cursor, end, &fontData, 1) || fontData.glyphCount < 0) {
+        return false;
+      }
+
+      font->ClearOutputData();
+      font->ContainerAtlas = atlas;
+      font->FontSize = fontData.fontSize;
+      font->Ascent = fontData.ascent;
+      font->Descent = fontData.descent;
+      font->MetricsTotalSurface = fontData.metricsTotalSurface;
+
+      font->Glyphs.resize(fontData.glyphCount);
+      if (!consume(cursor, end, font->Glyphs.Data, fontData.glyphCount)) {
+        return false;
+      }
+    }
+
+    for (auto &rect: atlas->CustomRects) {
+      RectData rectData = {};
+      if (!consume(cursor, end, &rectData, 1)) {
+        return false;
+      }
+      rect.X = rectData.x;
+      rect.Y = rectData.y;
+    }
+
+    for (auto &config: atlas->ConfigData) {
+      ImFont *font = config.DstFont;
+      if (!config.MergeMode) {
+        font->ConfigData = &config;
+        font->ConfigDataCount = 0;
+      }
+      font->ConfigDataCount++;
+    }
+
+    atlas->TexWidth = header.texWidth;
+    atlas->TexHeight = header.texHeight;
+    atlas->TexUvScale = header.texUvScale;
+    atlas->TexUvWhitePixel = header.texUvWhitePixel;
+    memcpy(atlas->TexUvLines, header.texUvLines, sizeof(atlas->TexUvLines));
+
+    for (auto font: atlas->Fonts) {
+      font->BuildLookupTable();
+    }
+
+    atlas->TexReady = true;
+    return true;
+  }
+
+  bool open(const char *path, u32 key, ImFontAtlas *atlas, CacheFile &file) {
+
+    file.isOpen = false;
+
+    if (nn::fs::OpenFile(&file.handle, path, nn::fs::OpenMode_Read)) {
+      Logger::log("No Font Atlas Cache at %s\n", path);
+      return false;
+    }
+    file.isOpen = true;
+
+    Header &header = file.header;
+    if (nn::fs::ReadFile(file.handle, 0, &header, sizeof(header)) || header.magic != Magic ||
+        header.version != Version || header.key != key) {
+      Logger::log("Font Atlas Cache is Outdated, Rebuilding it.\n");
+      close(file);
+      return false;
+    }
+
+    auto tables = (u8 *) Mem::Allocate(header.tablesSize);
+    if (!tables) {
+      Logger::log("Failed to Allocate Font Atlas Cache Tables! Size: %x\n", (u32) header.tablesSize);
+      close(file);
+      return false;
+    }
+
+    bool isRestored = !nn::fs::ReadFile(file.handle, sizeof(header), tables, header.tablesSize) &&
+                      restoreAtlas(atlas, header, tables, tables + header.tablesSize);
+    Mem::Deallocate(tables);
+
+    if (!isRestored) {
+      Logger::log("Font Atlas Cache is Invalid, Rebuilding it.\n");
+      close(file);
+      return false;
+    }
+
+    return true;
+  }
+
+  bool readStorage(CacheFile &file, void *storage, size_t size) {
+
+    if (!file.isOpen || size < file.header.storageSize) {
+      return false;
+    }
+
+    return !nn::fs::ReadFile(file.handle, sizeof(Header) + file.header.tablesSize, storage, file.header.storageSize);
+  }
+
+  void close(CacheFile &file) {
+    if (file.isOpen) {
+      nn::fs::CloseFile(file.handle);
+      file.isOpen = false;
+    }
+  }
+
+  bool save(const char *path, u32 key, ImFontAtlas *atlas, const void *storage, size_t storageSize) {
+
+    if (atlas->TexPixelsUseColors) {
+      Logger::log("Font Atlas has Colored Glyphs, not Caching it.\n");
+      return false;
+    }
+
+    ImVector<u8> tables;
+
+    for (auto font: atlas->Fonts) {
+      FontData fontData = {
+          .fontSize = font->FontSize,
+          .ascent = font->Ascent,
+          .descent = font->Descent,
+          .metricsTotalSurface = font->MetricsTotalSurface,
+          .glyphCount = font->Glyphs.Size
+      };
+      append(tables, &fontData, 1);
+      append(tables, font->Glyphs.Data, font->Glyphs.Size);
+    }
+
+    for (auto &rect: atlas->CustomRects) {
+      RectData rectData = {.x = rect.X, .y = rect.Y};
+      append(tables, &rectData, 1);
+    }
+
+    Header header = {
+        .magic = Magic,
+        .version = Version,
+        .key = key,
+        .texWidth = atlas->TexWidth,
+        .texHeight = atlas->TexHeight,
+        .texUvScale = atlas->TexUvScale,
+        .texUvWhitePixel = atlas->TexUvWhitePixel,
+        .texUvLines = {},
+        .fontCount = atlas->Fonts.Size,
+        .customRectCount = atlas->CustomRects.Size,
+        .tablesSize = (u64) tables.Size,
+        .storageSize = storageSize
+    };
+    memcpy(header.texUvLines, atlas->TexUvLines, sizeof(header.texUvLines));
+
+    ImVector<u8> data;
+    data.reserve((int) (sizeof(header) + tables.Size + storageSize));
+    append(data, &header, 1);
+    append(data, tables.Data, tables.Size);
+    append(data, (const u8 *) storage, storageSize);
+
+    FsHelper::createDirectory(IMGUI_XENO_FONT_CACHE_PATH);
+
+    if (FsHelper::writeFileToPath(data.Data, data.Size, path)) {
+      Logger::log("Failed to Write Font Atlas Cache!\n");
+      return false;
+    }
+
+    return true;
+  }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "imgui.h"
+#include "nn/fs.h"
+#include "types.h"
+
+// finished font atlases saved to the SD card, so later boots can skip rasterizing them. a cache file holds the glyph
+// tables of every font, and the atlas texture's storage as the GPU reads it, which gets read straight into the
+// texture's memory. only valid for the ImGui build and fonts it was made with, see getKey
+namespace FontAtlasCache {
+
+  static constexpr u32 Magic = 0x544E4658; // "XFNT"
+  static constexpr u32 Version = 1;
+
+  struct Header {
+    u32 magic;
+    u32 version;
+    u32 key;
+    s32 texWidth;
+    s32 texHeight;
+    ImVec2 texUvScale;
+    ImVec2 texUvWhitePixel;
+    ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    s32 fontCount;
+    s32 customRectCount;
+    // size of the glyph tables following the header, and of the texture storage following them
+    u64 tablesSize;
+    u64 storageSize;
+  };
+
+  // followed by glyphCount ImFontGlyph
+  struct FontData {
+    float fontSize;
+    float ascent;
+    float descent;
+    s32 metricsTotalSurface;
+    s32 glyphCount;
+  };
+
+  // where the atlas build placed each custom rect (mouse cursors, baked lines, user rects)
+  struct RectData {
+    u16 x;
+    u16 y;
+  };
+
+  struct CacheFile {
+    nn::fs::FileHandle handle;
+    bool isOpen;
+    Header header;
+  };
+
+  // hashes everything the atlas build depends on: the fonts' data, sizes and glyph ranges, the atlas settings, the
+  // ImGui version and the texture format. must be called before the atlas gets built
+  u32 getKey(ImFontAtlas *atlas, u32 texFormat);
+
+  // restores the atlas' glyph tables from the cache, if its key matches. the atlas is then ready to use, but has no
+  // CPU side pixels: the texture storage (header.storageSize bytes) must be read with readStorage
+  bool open(const char *path, u32 key, ImFontAtlas *atlas, CacheFile &file);
+
+  bool readStorage(CacheFile &file, void *storage, size_t size);
+
+  void close(CacheFile &file);
+
+  // writes the built atlas' tables and its texture storage, atlases with colored glyphs aren't cached
+  bool save(const char *path, u32 key, ImFontAtlas *atlas, const void *storage, size_t storageSize);
+}
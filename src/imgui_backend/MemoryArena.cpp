@@ -0,0 +1,259 @@
+#include "MemoryArena.h"
+#include "helpers/memoryHelper.h"
+#include "imgui_impl_nvn.hpp"
+#include "logger/Logger.hpp"
+
+static size_t getBlockSize(size_t size) {
+  size_t result = MemoryArena::MinBlockSize;
+  while (result < size) {
+    result <<= 1;
+  }
+  return result;
+}
+
+MemoryArena *MemoryArena::getArena(const nvn::MemoryPoolFlags &flags) {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  for (auto arena: bd->arenas) {
+    if (arena->flags == flags) {
+      return arena;
+    }
+  }
+
+  auto *arena = IM_NEW(MemoryArena)(flags);
+  bd->arenas.push_back(arena);
+  return arena;
+}
+
+// pools need 0x1000 aligned storage, a dedicated chunk's allocation starts at its beginning so it might need more
+int MemoryArena::createChunk(size_t size, bool isDedicated, size_t alignment) {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  void *storage = Mem::AllocateAlign(alignment > 0x1000 ? alignment : 0x1000, size);
+  if (!storage) {
+    Logger::log("Failed to Allocate Arena Chunk! Size: %x\n", size);
+    return -1;
+  }
+  memset(storage, 0, size);
+
+  auto *chunk = IM_NEW(Chunk)();
+
+  bd->memPoolBuilder.SetDefaults()
+      .SetDevice(bd->device)
+      .SetFlags(flags)
+      .SetStorage(storage, size);
+
+  if (!chunk->pool.Initialize(&bd->memPoolBuilder)) {
+    Logger::log("Failed to Create Memory Pool!\n");
+    Mem::Deallocate(storage);
+    IM_DELETE(chunk);
+    return -1;
+  }
+
+  chunk->storage = storage;
+  chunk->cpuPtr = (int) (flags & nvn::MemoryPoolFlags::CPU_NO_ACCESS) ? nullptr : (u8 *) chunk->pool.Map();
+  chunk->size = size;
+  chunk->isDedicated = isDedicated;
+
+  if (!isDedicated) {
+    chunk->freeLists[0].push_back(0);
+  }
+
+  // reuse slots left behind by released chunks
+  for (int i = 0; i < chunks.Size; i++) {
+    if (!chunks[i]) {
+      chunks[i] = chunk;
+      return i;
+    }
+  }
+
+  chunks.push_back(chunk);
+  return chunks.Size - 1;
+}
+
+void MemoryArena::releaseChunk(int chunkIdx) {
+
+  Chunk *chunk = chunks[chunkIdx];
+
+  chunk->pool.Finalize();
+  Mem::Deallocate(chunk->storage);
+  IM_DELETE(chunk);
+  chunks[chunkIdx] = nullptr;
+}
+
+bool MemoryArena::hasOtherRegularChunk(int chunkIdx) const {
+
+  for (int i = 0; i < chunks.Size; i++) {
+    if (i != chunkIdx && chunks[i] && !chunks[i]->isDedicated) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MemoryArena::allocateBlock(Allocation *result, size_t blockSize) {
+
+  int level = LevelCount - getArenaLevelCount(blockSize, MinBlockSize);
+
+  for (int chunkIdx = 0; chunkIdx < chunks.Size; chunkIdx++) {
+    Chunk *chunk = chunks[chunkIdx];
+    if (!chunk || chunk->isDedicated) {
+      continue;
+    }
+
+    // find the smallest free block that fits...
+    int freeLevel = level;
+    while (freeLevel >= 0 && chunk->freeLists[freeLevel].empty()) {
+      freeLevel--;
+    }
+
+    if (freeLevel < 0) {
+      continue;
+    }
+
+    ptrdiff_t offset = chunk->freeLists[freeLevel].back();
+    chunk->freeLists[freeLevel].pop_back();
+
+    // ...then split it down to the requested size, keeping the upper halves free
+    while (freeLevel < level) {
+      freeLevel++;
+      chunk->freeLists[freeLevel].push_back(offset + (ptrdiff_t) (ChunkSize >> freeLevel));
+    }
+
+    result->pool = &chunk->pool;
+    result->offset = offset;
+    result->size = blockSize;
+    result->cpuPtr = chunk->cpuPtr ? chunk->cpuPtr + offset : nullptr;
+    result->arena = this;
+    result->chunkIdx = chunkIdx;
+
+    return true;
+  }
+
+  return false;
+}
+
+void MemoryArena::freeBlock(Chunk *chunk, ptrdiff_t offset, size_t blockSize) {
+
+  int level = LevelCount - getArenaLevelCount(blockSize, MinBlockSize);
+
+  // merge back with the buddy block for as long as it is free too
+  while (level > 0) {
+    ptrdiff_t buddy = offset ^ (ptrdiff_t) (ChunkSize >> level);
+
+    auto &freeList = chunk->freeLists[level];
+    ptrdiff_t *it = freeList.find(buddy);
+    if (it == freeList.end()) {
+      break;
+    }
+
+    freeList.erase_unsorted(it);
+    offset = offset < buddy ? offset : buddy;
+    level--;
+  }
+
+  chunk->freeLists[level].push_back(offset);
+}
+
+bool MemoryArena::allocate(Allocation *result, size_t size, size_t blockSize, size_t alignment) {
+
+  // big allocations get a pool of their own, so they don't hog entire chunks
+  if (blockSize > ChunkSize / 2) {
+    int chunkIdx = createChunk(ALIGN_UP(size, 0x1000), true, alignment);
+    if (chunkIdx < 0) {
+      return false;
+    }
+
+    Chunk *chunk = chunks[chunkIdx];
+
+    result->pool = &chunk->pool;
+    result->offset = 0;
+    result->size = chunk->size;
+    result->cpuPtr = chunk->cpuPtr;
+    result->arena = this;
+    result->chunkIdx = chunkIdx;
+
+    usedSize += chunk->size;
+    return true;
+  }
+
+  if (!allocateBlock(result, blockSize)) {
+    if (createChunk(ChunkSize, false, 0x1000) < 0 || !allocateBlock(result, blockSize)) {
+      Logger::log("Failed to Allocate %x bytes from Memory Arena!\n", size);
+      return false;
+    }
+  }
+
+  usedSize += blockSize;
+  return true;
+}
+
+bool MemoryArena::Allocate(Allocation *result, size_t size, const nvn::MemoryPoolFlags &flags, size_t alignment) {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  // buddy blocks are aligned to their own size, so rounding up to the alignment is enough
+  size_t blockSize = getBlockSize(size > alignment ? size : alignment);
+
+  nn::os::LockMutex(&bd->arenaMutex);
+  bool isAllocated = getArena(flags)->allocate(result, size, blockSize, alignment);
+  nn::os::UnlockMutex(&bd->arenaMutex);
+
+  return isAllocated;
+}
+
+void MemoryArena::Free(Allocation &allocation) {
+
+  MemoryArena *arena = allocation.arena;
+  if (!arena) {
+    return;
+  }
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  nn::os::LockMutex(&bd->arenaMutex);
+
+  Chunk *chunk = arena->chunks[allocation.chunkIdx];
+  arena->usedSize -= allocation.size;
+
+  if (chunk->isDedicated) {
+    arena->releaseChunk(allocation.chunkIdx);
+  } else {
+    arena->freeBlock(chunk, allocation.offset, allocation.size);
+
+    // the whole chunk merged back into a single free block. the last one is kept, so an arena that keeps allocating
+    // and freeing a buffer doesn't create a pool every time
+    if (!chunk->freeLists[0].empty() && arena->hasOtherRegularChunk(allocation.chunkIdx)) {
+      arena->releaseChunk(allocation.chunkIdx);
+    }
+  }
+
+  nn::os::UnlockMutex(&bd->arenaMutex);
+
+  allocation = {};
+}
+
+void MemoryArena::LogStats() {
+
+  auto bd = ImguiNvnBackend::getBackendData();
+
+  nn::os::LockMutex(&bd->arenaMutex);
+
+  for (auto arena: bd->arenas) {
+    int poolCount = 0;
+    size_t reservedSize = 0;
+    for (auto chunk: arena->chunks) {
+      if (chunk) {
+        poolCount++;
+        reservedSize += chunk->size;
+      }
+    }
+
+    Logger::log("Memory Arena (Flags: %x): %d Pool(s), %x bytes reserved, %x bytes used\n", (int) arena->flags,
+                poolCount, reservedSize, arena->usedSize);
+  }
+
+  nn::os::UnlockMutex(&bd->arenaMutex);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "imgui.h"
+#include "imgui_backend_config.h"
+#include "nvn_Cpp.h"
+#include "nvn_CppMethods.h"
+#include "types.h"
+
+// number of buddy levels between a block of the given size and the smallest block. outside of the class, as member
+// functions can't be used in its constant expressions before the class is complete
+static constexpr int getArenaLevelCount(size_t size, size_t minBlockSize) {
+  int count = 1;
+  while (size > minBlockSize) {
+    size >>= 1;
+    count++;
+  }
+  return count;
+}
+
+// sub-allocates aligned ranges out of a few large memory pools (one arena per MemoryPoolFlags combination), instead
+// of creating a separate 0x1000 aligned pool for every buffer/texture. each chunk is managed by a buddy allocator.
+class MemoryArena {
+public:
+  // smallest block handed out, also the minimum alignment of every allocation (enough for UBOs and shader code)
+  static constexpr size_t MinBlockSize = 0x100;
+  static constexpr size_t ChunkSize = IMGUI_XENO_ARENA_CHUNK_SIZE;
+
+  static_assert(ChunkSize >= 0x1000 && (ChunkSize & (ChunkSize - 1)) == 0,
+                "Arena chunk size must be a power of two, and at least 0x1000");
+
+  struct Allocation {
+    nvn::MemoryPool *pool;
+    ptrdiff_t offset;
+    size_t size;
+    // nullptr if the pool is not CPU accessible
+    u8 *cpuPtr;
+
+    MemoryArena *arena;
+    int chunkIdx;
+  };
+
+  // both lock the backend's arena mutex, so they can be called from any thread
+  static bool Allocate(Allocation *result, size_t size,
+                       const nvn::MemoryPoolFlags &flags = nvn::MemoryPoolFlags::CPU_UNCACHED |
+                                                           nvn::MemoryPoolFlags::GPU_CACHED,
+                       size_t alignment = MinBlockSize);
+
+  static void Free(Allocation &allocation);
+
+  static void LogStats();
+
+private:
+  static constexpr int LevelCount = getArenaLevelCount(ChunkSize, MinBlockSize);
+
+  struct Chunk {
+    nvn::MemoryPool pool;
+    void *storage;
+    u8 *cpuPtr;
+    size_t size;
+    // dedicated chunks hold a single allocation that didn't fit a regular chunk, and are released with it. regular
+    // chunks are released once empty, unless they are the last one of the arena
+    bool isDedicated;
+    // offsets of free blocks for each level, level 0 being a single block covering the whole chunk
+    ImVector<ptrdiff_t> freeLists[LevelCount];
+  };
+
+  explicit MemoryArena(const nvn::MemoryPoolFlags &flags) : flags(flags) {}
+
+  static MemoryArena *getArena(const nvn::MemoryPoolFlags &flags);
+
+  bool allocate(Allocation *result, size_t size, size_t blockSize, size_t alignment);
+
+  int createChunk(size_t size, bool isDedicated, size_t alignment);
+
+  void releaseChunk(int chunkIdx);
+
+  bool hasOtherRegularChunk(int chunkIdx) const;
+
+  bool allocateBlock(Allocation *result, size_t blockSize);
+
+  void freeBlock(Chunk *chunk, ptrdiff_t offset, size_t blockSize);
+
+  nvn::MemoryPoolFlags flags;
+  ImVector<Chunk *> chunks;
+
+  size_t usedSize = 0;
+};
@@ -1,100 +1,52 @@
 #include "MemoryBuffer.h"
 #include "imgui_impl_nvn.hpp"
 #include "logger/Logger.hpp"
-#include "helpers/memoryHelper.h"
 
 MemoryBuffer::MemoryBuffer(size_t size) {
-
-  auto *bd = ImguiNvnBackend::getBackendData();
-
-  size_t alignedSize = ALIGN_UP(size, 0x1000);
-
-  memBuffer = Mem::AllocateAlign(0x1000, alignedSize);
-  memset(memBuffer, 0, alignedSize);
-
-  bd->memPoolBuilder.SetDefaults()
-      .SetDevice(bd->device)
-      .SetFlags(nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED)
-      .SetStorage(memBuffer, alignedSize);
-
-  if (!pool.Initialize(&bd->memPoolBuilder)) {
-    Logger::log("Failed to Create Memory Pool!\n");
-    return;
-  }
-
-  bd->bufferBuilder.SetDevice(bd->device).SetDefaults().SetStorage(&pool, 0, alignedSize);
-
-  if (!buffer.Initialize(&bd->bufferBuilder)) {
-    Logger::log("Failed to Init Buffer!\n");
-    return;
+  if (initBuffer(size, nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED)) {
+    ClearBuffer();
   }
-
-  mIsReady = true;
 }
 
 MemoryBuffer::MemoryBuffer(size_t size, nvn::MemoryPoolFlags flags) {
-
-  auto *bd = ImguiNvnBackend::getBackendData();
-
-  size_t alignedSize = ALIGN_UP(size, 0x1000);
-
-  memBuffer = Mem::AllocateAlign(0x1000, alignedSize);
-  memset(memBuffer, 0, alignedSize);
-
-  bd->memPoolBuilder.SetDefaults()
-      .SetDevice(bd->device)
-      .SetFlags(flags)
-      .SetStorage(memBuffer, alignedSize);
-
-  if (!pool.Initialize(&bd->memPoolBuilder)) {
-    Logger::log("Failed to Create Memory Pool!\n");
-    return;
+  if (initBuffer(size, flags) && allocation.cpuPtr) {
+    ClearBuffer();
   }
+}
 
-  bd->bufferBuilder.SetDevice(bd->device).SetDefaults().SetStorage(&pool, 0, alignedSize);
-
-  if (!buffer.Initialize(&bd->bufferBuilder)) {
-    Logger::log("Failed to Init Buffer!\n");
-    return;
+MemoryBuffer::MemoryBuffer(size_t size, void *bufferPtr, nvn::MemoryPoolFlags flags) {
+  if (initBuffer(size, flags)) {
+    memcpy(allocation.cpuPtr, bufferPtr, size);
   }
-
-  mIsReady = true;
 }
 
-MemoryBuffer::MemoryBuffer(size_t size, void *bufferPtr, nvn::MemoryPoolFlags flags) {
+bool MemoryBuffer::initBuffer(size_t size, const nvn::MemoryPoolFlags &flags) {
 
   auto *bd = ImguiNvnBackend::getBackendData();
 
-  // Copy to respect alignment for both size and pointer
-  memBuffer = Mem::AllocateAlign(0x1000, size);
-  memcpy(memBuffer, bufferPtr, size);
-
-  bd->memPoolBuilder.SetDefaults()
-      .SetDevice(bd->device)
-      .SetFlags(flags)
-      .SetStorage(memBuffer, size);
-
-  if (!pool.Initialize(&bd->memPoolBuilder)) {
+  // sub-allocate from the arena matching our flags, instead of creating a pool of our own
+  if (!MemoryArena::Allocate(&allocation, size, flags)) {
     Logger::log("Failed to Create Memory Pool!\n");
-    return;
+    return false;
   }
 
-  bd->bufferBuilder.SetDevice(bd->device).SetDefaults().SetStorage(&pool, 0, size);
+  bd->bufferBuilder.SetDevice(bd->device).SetDefaults().SetStorage(allocation.pool, allocation.offset,
+                                                                    allocation.size);
 
   if (!buffer.Initialize(&bd->bufferBuilder)) {
     Logger::log("Failed to Init Buffer!\n");
-    return;
+    return false;
   }
 
   mIsReady = true;
+  return true;
 }
 
 void MemoryBuffer::Finalize() {
-  IM_FREE(memBuffer);
-  pool.Finalize();
   buffer.Finalize();
+  MemoryArena::Free(allocation);
 }
 
 void MemoryBuffer::ClearBuffer() {
-  memset(memBuffer, 0, pool.GetSize());
-}
\ No newline at end of file
+  memset(allocation.cpuPtr, 0, allocation.size);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MemoryArena.h"
 #include "nvn_Cpp.h"
 #include "nvn_CppMethods.h"
 #include "types.h"
@@ -14,11 +15,11 @@ public:
 
   void Finalize();
 
-  size_t GetPoolSize() const { return pool.GetSize(); }
+  size_t GetPoolSize() const { return allocation.size; }
 
   nvn::BufferAddress GetBufferAddress() const { return buffer.GetAddress(); };
 
-  u8 *GetMemPtr() const { return (u8 *) pool.Map(); }
+  u8 *GetMemPtr() const { return allocation.cpuPtr; }
 
   bool IsBufferReady() { return mIsReady; }
 
@@ -27,9 +28,10 @@ public:
   operator nvn::BufferAddress() const { return buffer.GetAddress(); }
 
 private:
-  nvn::MemoryPool pool;
+  bool initBuffer(size_t size, const nvn::MemoryPoolFlags &flags);
+
+  MemoryArena::Allocation allocation = {};
   nvn::Buffer buffer;
 
-  void *memBuffer;
   bool mIsReady = false;
-};
\ No newline at end of file
+};
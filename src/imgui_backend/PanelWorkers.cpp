@@ -0,0 +1,346 @@
+#include "PanelWorkers.h"
+
+#if IMGUI_XENO_PANEL_THREADS > 0
+
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+// glyphs are rasterized into the shared atlas by whichever thread draws them first
+#error "IMGUI_XENO_PANEL_THREADS can't be used with IMGUI_XENO_DYNAMIC_FONT_ATLAS"
+#endif
+
+#include "helpers/InputHelper.h"
+#include "helpers/memoryHelper.h"
+#include "imgui_impl_nvn.hpp"
+#include "imgui_internal.h"
+#include "logger/Logger.hpp"
+#include "nn/os.h"
+
+struct Panel {
+  ProcDrawFunc func;
+  ImGuiContext *context;
+  // whether the panel got the input on its last update
+  bool hasInput;
+  float lastMs;
+};
+
+struct Worker {
+  nn::os::ThreadType thread;
+  void *stack;
+  // current ImGui context of the worker's thread
+  ImGuiContext *context;
+};
+
+// panels are only ever appended, so indices stay valid. workers get passed Panel pointers, since the vector can grow
+static ImVector<Panel *> __panels;
+// panels that are part of the current update, panels added during it wait for the next one
+static int __activePanelCount = 0;
+
+// holds a pointer to the current context of each worker, null on every other thread
+static nn::os::TlsSlot __contextSlot;
+static bool __hasContextSlot = false;
+// current context of every thread that isn't a panel worker (the render thread and the async frame worker)
+static ImGuiContext *__mainContext = nullptr;
+
+static Worker __workers[IMGUI_XENO_PANEL_THREADS];
+static int __workerCount = 0;
+
+// building thread -> workers: panel to build. workers -> building thread: panel that was built
+static nn::os::MessageQueueType __jobQueue;
+static nn::os::MessageQueueType __doneQueue;
+static u64 __jobBuffer[PanelWorkers::MaxPanels];
+static u64 __doneBuffer[PanelWorkers::MaxPanels];
+
+// index of the panel that gets the input, -1 for the main context
+static int __inputOwner = -1;
+static ImVec2 __mousePos(-FLT_MAX, -FLT_MAX);
+static float __panelWaitMs = 0.0f;
+
+ImGuiContext *&xenoCurrentContext() {
+  if (__hasContextSlot) {
+    if (auto *context = (ImGuiContext **) nn::os::GetTlsValue(__contextSlot)) {
+      return *context;
+    }
+  }
+  return __mainContext;
+}
+
+static void createPanelContext(Panel &panel) {
+  ImGuiContext *mainContext = ImGui::GetCurrentContext();
+  ImGuiIO &mainIo = ImGui::GetIO();
+
+  // sharing the atlas means the backend's font texture works as is
+  panel.context = ImGui::CreateContext(mainIo.Fonts);
+
+  ImGui::SetCurrentContext(panel.context);
+
+  ImGuiIO &io = ImGui::GetIO();
+  // several contexts would keep overwriting each other's ini file
+  io.IniFilename = nullptr;
+  io.ConfigFlags = mainIo.ConfigFlags;
+  io.BackendFlags = mainIo.BackendFlags;
+  ImGui::GetStyle() = mainContext->Style;
+
+  ImGui::SetCurrentContext(mainContext);
+}
+
+static void buildPanel(Panel &panel) {
+  nn::os::Tick startTick = nn::os::GetSystemTick();
+
+  ImGuiContext *prevContext = ImGui::GetCurrentContext();
+  ImGui::SetCurrentContext(panel.context);
+
+  ImGui::NewFrame();
+  ImGui::GetIO().MouseDrawCursor = panel.hasInput && InputHelper::toggleInput && ImGui::GetMousePos().x >= 1 &&
+                                   ImGui::GetMousePos().y >= 1;
+
+  panel.func();
+
+  ImGui::Render();
+
+  ImGui::SetCurrentContext(prevContext);
+
+  panel.lastMs = ImguiNvnBackend::getElapsedMs(startTick);
+}
+
+static void workerMain(void *arg) {
+  auto *worker = (Worker *) arg;
+  nn::os::SetTlsValue(__contextSlot, (u64) &worker->context);
+
+  while (true) {
+    u64 message;
+    nn::os::ReceiveMessageQueue(&message, &__jobQueue);
+
+    buildPanel(*(Panel *) message);
+
+    nn::os::SendMessageQueue(&__doneQueue, message);
+  }
+}
+
+// spreads the workers over the cores allowed by IMGUI_XENO_PANEL_CORE_MASK
+static int getWorkerCore(int workerIdx) {
+  constexpr u64 coreMask = IMGUI_XENO_PANEL_CORE_MASK;
+  static_assert(coreMask != 0, "Panel workers need at least one core");
+
+  int idx = workerIdx % __builtin_popcountll(coreMask);
+  for (int core = 0; core < 64; core++) {
+    if ((coreMask >> core) & 1 && idx-- == 0) {
+      return core;
+    }
+  }
+  return 0;
+}
+
+bool PanelWorkers::addPanel(ProcDrawFunc func) {
+#if IMGUI_VERSION_NUM < 18980
+  // merging draw data needs ImDrawData::AddDrawList
+  return false;
+#else
+  if (__panels.Size >= MaxPanels) {
+    Logger::log("Too many Panels! Running it as a Draw Callback instead.\n");
+    return false;
+  }
+
+  auto *panel = IM_NEW(Panel)();
+  panel->func = func;
+  __panels.push_back(panel);
+  return true;
+#endif
+}
+
+bool PanelWorkers::start() {
+
+  if (R_FAILED(nn::os::AllocateTlsSlot(&__contextSlot, nullptr))) {
+    Logger::log("Failed to Allocate ImGui Context TLS Slot!\n");
+    return false;
+  }
+  __hasContextSlot = true;
+
+  nn::os::InitializeMessageQueue(&__jobQueue, __jobBuffer, MaxPanels);
+  nn::os::InitializeMessageQueue(&__doneQueue, __doneBuffer, MaxPanels);
+
+  for (int i = 0; i < IMGUI_XENO_PANEL_THREADS; i++) {
+    Worker &worker = __workers[i];
+
+    worker.stack = Mem::AllocateAlign(0x1000, IMGUI_XENO_PANEL_STACK_SIZE);
+    if (!worker.stack) {
+      Logger::log("Failed to Allocate Panel Worker Stack!\n");
+      break;
+    }
+
+    if (R_FAILED(nn::os::CreateThread(&worker.thread, workerMain, &worker, worker.stack, IMGUI_XENO_PANEL_STACK_SIZE,
+                                      IMGUI_XENO_PANEL_THREAD_PRIORITY, getWorkerCore(i)))) {
+      Logger::log("Failed to Create Panel Worker Thread!\n");
+      Mem::Deallocate(worker.stack);
+      break;
+    }
+
+    nn::os::SetThreadName(&worker.thread, "ImGuiPanelWorker");
+    nn::os::StartThread(&worker.thread);
+    __workerCount++;
+  }
+
+  Logger::log("Started %d Panel Worker Thread(s).\n", __workerCount);
+
+  return __workerCount > 0;
+}
+
+static bool isOverPanel(const Panel &panel, const ImVec2 &pos) {
+  for (auto window: panel.context->Windows) {
+    if (ImGui::IsWindowActiveAndVisible(window) && !(window->Flags & ImGuiWindowFlags_NoMouseInputs) &&
+        window->Rect().Contains(pos)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool isAnyMouseDown(const ImGuiContext *context) {
+  for (bool isDown: context->IO.MouseDown) {
+    if (isDown) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the context under the mouse gets all of the input, the others only see the app losing focus
+static int findInputOwner() {
+  const ImGuiContext *ownerContext = __inputOwner < 0 ? __mainContext : __panels[__inputOwner]->context;
+
+  // keep the owner while a button is held, so drags don't get cut off when leaving its windows
+  if (isAnyMouseDown(ownerContext)) {
+    return __inputOwner;
+  }
+
+  // panels are drawn on top of the main context, the last one topmost
+  for (int i = __activePanelCount - 1; i >= 0; i--) {
+    if (__panels[i]->context && isOverPanel(*__panels[i], __mousePos)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void setContextFocus(ImGuiContext *context, bool isFocused) {
+  ImGuiContext *prevContext = ImGui::GetCurrentContext();
+  ImGui::SetCurrentContext(context);
+
+  ImGuiIO &io = ImGui::GetIO();
+  io.AddFocusEvent(isFocused);
+  if (!isFocused) {
+    io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+  }
+
+  ImGui::SetCurrentContext(prevContext);
+}
+
+void PanelWorkers::beginPanels() {
+  __activePanelCount = __panels.Size;
+  if (__activePanelCount == 0) {
+    return;
+  }
+
+  ImGuiContext *mainContext = ImGui::GetCurrentContext();
+
+  for (auto &event: mainContext->InputEventsQueue) {
+    if (event.Type == ImGuiInputEventType_MousePos) {
+      __mousePos = ImVec2(event.MousePos.PosX, event.MousePos.PosY);
+    }
+  }
+
+  int owner = findInputOwner();
+
+  for (int i = 0; i < __activePanelCount; i++) {
+    Panel &panel = *__panels[i];
+    if (!panel.context) {
+      createPanelContext(panel);
+    }
+
+    bool hasInput = i == owner;
+    if (panel.hasInput != hasInput) {
+      setContextFocus(panel.context, hasInput);
+      panel.hasInput = hasInput;
+    }
+
+    if (hasInput) {
+      for (auto &event: mainContext->InputEventsQueue) {
+        panel.context->InputEventsQueue.push_back(event);
+      }
+    }
+
+    ImGuiIO &io = panel.context->IO;
+    io.DeltaTime = mainContext->IO.DeltaTime;
+    io.DisplaySize = mainContext->IO.DisplaySize;
+    io.DisplayFramebufferScale = mainContext->IO.DisplayFramebufferScale;
+  }
+
+  if (owner >= 0) {
+    mainContext->InputEventsQueue.resize(0);
+  }
+  if ((owner < 0) != (__inputOwner < 0)) {
+    setContextFocus(mainContext, owner < 0);
+  }
+  __inputOwner = owner;
+
+  if (__workerCount > 0) {
+    for (int i = 0; i < __activePanelCount; i++) {
+      nn::os::SendMessageQueue(&__jobQueue, (u64) __panels[i]);
+    }
+  }
+}
+
+void PanelWorkers::endPanels(ImDrawData *drawData) {
+  if (__activePanelCount == 0) {
+    return;
+  }
+
+  nn::os::Tick waitTick = nn::os::GetSystemTick();
+
+  for (int i = 0; i < __activePanelCount; i++) {
+    if (__workerCount > 0) {
+      u64 message;
+      nn::os::ReceiveMessageQueue(&message, &__doneQueue);
+    } else {
+      buildPanel(*__panels[i]);
+    }
+  }
+
+  __panelWaitMs = ImguiNvnBackend::getElapsedMs(waitTick);
+
+#if IMGUI_VERSION_NUM >= 18980
+  ImGuiContext *mainContext = ImGui::GetCurrentContext();
+
+  // panel draw lists stay valid until the panel's next NewFrame, on the next update
+  for (int i = 0; i < __activePanelCount; i++) {
+    ImGui::SetCurrentContext(__panels[i]->context);
+    ImDrawData *panelData = ImGui::GetDrawData();
+    ImGui::SetCurrentContext(mainContext);
+
+    if (!panelData) {
+      continue;
+    }
+
+    for (int listIdx = 0; listIdx < panelData->CmdListsCount; listIdx++) {
+      drawData->AddDrawList(panelData->CmdLists[listIdx]);
+    }
+  }
+#endif
+}
+
+bool PanelWorkers::isInteracting() {
+  if (__inputOwner < 0) {
+    return false;
+  }
+
+  const ImGuiContext *context = __panels[__inputOwner]->context;
+  return context->ActiveId != 0 || context->IO.WantTextInput;
+}
+
+void PanelWorkers::getStats(ImguiXenoFrameStats *stats) {
+  stats->panelCount = ImMin(__activePanelCount, IMGUI_XENO_MAX_CALLBACK_STATS);
+  for (int i = 0; i < stats->panelCount; i++) {
+    stats->panelMs[i] = __panels[i]->lastMs;
+  }
+  stats->panelWaitMs = __panelWaitMs;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "imgui.h"
+#include "imgui_backend_config.h"
+#include "xeno_types.h"
+
+// builds panels on worker threads, each in an ImGuiContext of its own sharing the main context's font atlas. a panel
+// is a draw callback that doesn't depend on any other callback, so all of them can run alongside the main context's
+// callbacks. their draw lists are then merged on top of the main context's draw data.
+namespace PanelWorkers {
+
+  static constexpr int MaxPanels = 16;
+
+  // returns false if the panel can't be added, it should then run as a regular draw callback
+  bool addPanel(ProcDrawFunc func);
+
+  // starts the worker threads. if none could be started, panels are built one after the other in endPanels
+  bool start();
+
+  // routes this update's input to the context under the mouse, and starts building the panels. must be called after
+  // the input was polled into the main context, but before its NewFrame
+  void beginPanels();
+
+  // waits for the panels to finish, and appends their draw lists to the main context's draw data
+  void endPanels(ImDrawData *drawData);
+
+  // whether the panel that has the input is in the middle of using a widget
+  bool isInteracting();
+
+  void getStats(ImguiXenoFrameStats *stats);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.h"
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+// table of intercepted proc names, hashed at compile time. a lookup hashes the requested name once and probes an
+// open addressing table, instead of comparing it against every hooked name
+namespace ProcHooks {
+
+  // saves the original proc, and returns the hook that replaces it
+  typedef void *(*InstallFunc)(void *original);
+
+  struct Entry {
+    const char *name = nullptr;
+    InstallFunc install = nullptr;
+  };
+
+  // FNV-1a
+  constexpr u32 hashName(const char *name) {
+    u32 hash = 0x811C9DC5;
+    while (*name) {
+      hash = (hash ^ (u8) *name++) * 0x01000193;
+    }
+    return hash;
+  }
+
+  template <auto &Original, auto Hook>
+  void *install(void *original) {
+    Original = (std::remove_reference_t<decltype(Original)>) original;
+    return (void *) Hook;
+  }
+
+  template <size_t EntryCount>
+  class Table {
+  public:
+    // at least twice the entry count, so probe chains stay short
+    static constexpr size_t SlotCount = std::bit_ceil(EntryCount * 2);
+
+    constexpr explicit Table(const Entry (&entries)[EntryCount]) {
+      for (auto &entry: entries) {
+        u32 hash = hashName(entry.name);
+
+        size_t idx = hash & (SlotCount - 1);
+        while (slots[idx].entry.name) {
+          idx = (idx + 1) & (SlotCount - 1);
+        }
+
+        slots[idx] = {hash, entry};
+      }
+    }
+
+    // returns nullptr if the proc isn't hooked
+    const Entry *find(const char *name) const {
+      u32 hash = hashName(name);
+
+      for (size_t idx = hash & (SlotCount - 1); slots[idx].entry.name; idx = (idx + 1) & (SlotCount - 1)) {
+        if (slots[idx].hash == hash && strcmp(slots[idx].entry.name, name) == 0) {
+          return &slots[idx].entry;
+        }
+      }
+
+      return nullptr;
+    }
+
+  private:
+    struct Slot {
+      u32 hash = 0;
+      Entry entry = {};
+    };
+
+    Slot slots[SlotCount];
+  };
+}
@@ -2,12 +2,17 @@
 #include "helpers.h"
 #include "imgui_hid_mappings.h"
 #include "logger/Logger.hpp"
+#include <cfloat>
 #include <cmath>
 
 #include "nn/hid.h"
+#include "nn/util.h"
 
 #include "helpers/InputHelper.h"
-#include "MemoryPoolMaker.h"
+#include "helpers/fsHelper.h"
+#include "DrawDataCapture.h"
+#include "FontAtlasCache.h"
+#include "MemoryArena.h"
 #include "imgui_backend_config.h"
 
 #if IMGUI_XENO_LOAD_DEFAULT_FONT
@@ -16,6 +21,14 @@
 
 #include "imgui_shader.h"
 
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS && IMGUI_VERSION_NUM < 19200
+#error "IMGUI_XENO_DYNAMIC_FONT_ATLAS needs ImGui 1.92 or newer"
+#endif
+
+#if IMGUI_XENO_FONT_CACHE && IMGUI_XENO_DYNAMIC_FONT_ATLAS
+#error "IMGUI_XENO_FONT_CACHE only applies to the static font atlas"
+#endif
+
 #define UBOSIZE 0x1000
 
 typedef float Matrix44f[4][4];
@@ -51,6 +64,8 @@ namespace ImguiNvnBackend {
   void loadIni();
   void saveIni();
 
+  void bindVertexBuffer(nvn::BufferAddress address, size_t size);
+
   // doesnt get used anymore really, as back when it was needed i had a simplified shader to test with, but now I just test with the actual imgui shader
   void initTestShader() {
 
@@ -175,7 +190,7 @@ namespace ImguiNvnBackend {
   void renderTestShader(ImDrawData *drawData) {
 
     auto bd = getBackendData();
-    auto io = ImGui::GetIO();
+    ImVec2 displaySize = drawData->DisplaySize;
 
     constexpr int triVertCount = 3;
     constexpr int quadVertCount = triVertCount * 2;
@@ -184,38 +199,37 @@ namespace ImguiNvnBackend {
 
     int pointCount = quadVertCount * quadCount;
 
-    size_t totalVtxSize = pointCount * sizeof(ImDrawVert);
-    if (!bd->vtxBuffer || bd->vtxBuffer->GetPoolSize() < totalVtxSize) {
-      if (bd->vtxBuffer) {
-        bd->vtxBuffer->Finalize();
-        IM_FREE(bd->vtxBuffer);
-      }
-      bd->vtxBuffer = IM_NEW(MemoryBuffer)(totalVtxSize);
-      Logger::log("(Re)sized Vertex Buffer to Size: %d\n", totalVtxSize);
-    }
+    // this frame takes over a slot of the ring, which might hold the geometry of the recorded frame
+    invalidateRecordedFrame();
 
-    if (!bd->vtxBuffer->IsBufferReady()) {
+    FrameResources &frame = acquireFrame();
+
+    size_t totalVtxSize = pointCount * sizeof(ImDrawVert);
+    if (!growStreamBuffer(frame.vtxBuffer, totalVtxSize, bd->vtxStats, "Vertex")) {
       Logger::log("Cannot Draw Data! Buffers are not Ready.\n");
       return;
     }
 
-    ImDrawVert *verts = (ImDrawVert *) bd->vtxBuffer->GetMemPtr();
+    ImDrawVert *verts = (ImDrawVert *) frame.vtxBuffer.memory->GetMemPtr();
 
     float scale = 3.0f;
 
     float imageX = 1 * scale; // bd->fontTexture.GetWidth();
     float imageY = 1 * scale; // bd->fontTexture.GetHeight();
 
-    createQuad(verts, 0, (io.DisplaySize.x / 2) - (imageX), (io.DisplaySize.y / 2) - (imageY), imageX, imageY,
+    createQuad(verts, 0, (displaySize.x / 2) - (imageX), (displaySize.y / 2) - (imageY), imageX, imageY,
                IM_COL32_WHITE);
 
-    bd->cmdBuf->BeginRecording();
+    if (!beginFrameCommands(frame)) {
+      return;
+    }
+    resetStateCache();
     bd->cmdBuf->BindProgram(&bd->shaderProgram, nvn::ShaderStageBits::VERTEX | nvn::ShaderStageBits::FRAGMENT);
 
     bd->cmdBuf->BindUniformBuffer(nvn::ShaderStage::VERTEX, 0, *bd->uniformMemory, UBOSIZE);
     bd->cmdBuf->UpdateUniformBuffer(*bd->uniformMemory, UBOSIZE, 0, sizeof(projMatrix), &projMatrix);
 
-    bd->cmdBuf->BindVertexBuffer(0, (*bd->vtxBuffer), bd->vtxBuffer->GetPoolSize());
+    bindVertexBuffer(*frame.vtxBuffer.memory, frame.vtxBuffer.memory->GetPoolSize());
 
     setRenderStates();
 
@@ -223,8 +237,9 @@ namespace ImguiNvnBackend {
 
     bd->cmdBuf->DrawArrays(nvn::DrawPrimitive::TRIANGLES, 0, pointCount);
 
-    auto handle = bd->cmdBuf->EndRecording();
-    bd->queue->SubmitCommands(1, &handle);
+    submitFrameCommands();
+
+    releaseFrame(frame);
   }
 
 // backend impl
@@ -267,6 +282,139 @@ namespace ImguiNvnBackend {
     return false;
   }
 
+  // rasterizes the atlas, unless it already was, and returns its texels in the format of the font texture
+  static void getFontTexels(ImFontAtlas *atlas, unsigned char **pixels, int *width, int *height) {
+    int pixelByteSize;
+#if IMGUI_XENO_ALPHA8_FONT
+    atlas->GetTexDataAsAlpha8(pixels, width, height, &pixelByteSize);
+#else
+    atlas->GetTexDataAsRGBA32(pixels, width, height, &pixelByteSize);
+#endif
+  }
+
+  // bakes the whole atlas and uploads it at once, used unless the atlas is dynamic. with the font cache, a cached atlas
+  // gets its texture storage read straight into the font memory instead, skipping both rasterization and the upload
+  bool setupFontTexture() {
+
+    auto bd = getBackendData();
+
+    ImGuiIO &io = ImGui::GetIO();
+
+    nvn::Format format = IMGUI_XENO_ALPHA8_FONT ? nvn::Format::R8 : nvn::Format::RGBA8;
+
+    nn::os::Tick startTick = nn::os::GetSystemTick();
+
+    unsigned char *pixels = nullptr;
+    int width, height;
+    bool isCached = false;
+    // included in the total time below, but logged on its own as it usually is most of it
+    float rasterizeMs = 0.0f;
+
+#if IMGUI_XENO_FONT_CACHE
+    char cachePath[0x100];
+    nn::util::SNPrintf(cachePath, sizeof(cachePath), "%s/font_atlas.bin", IMGUI_XENO_FONT_CACHE_PATH);
+
+    FontAtlasCache::CacheFile cacheFile = {};
+    u32 cacheKey = FontAtlasCache::getKey(io.Fonts, (u32) format);
+    isCached = FontAtlasCache::open(cachePath, cacheKey, io.Fonts, cacheFile);
+    if (isCached) {
+      width = cacheFile.header.texWidth;
+      height = cacheFile.header.texHeight;
+    }
+#endif
+
+    // convert imgui font texels
+
+    if (!isCached) {
+      nn::os::Tick rasterizeTick = nn::os::GetSystemTick();
+      getFontTexels(io.Fonts, &pixels, &width, &height);
+      rasterizeMs = getElapsedMs(rasterizeTick);
+    }
+
+    bd->texBuilder.SetDefaults()
+        .SetDevice(bd->device)
+        .SetTarget(nvn::TextureTarget::TARGET_2D)
+        .SetFormat(format)
+        .SetSize2D(width, height);
+
+#if IMGUI_XENO_ALPHA8_FONT
+    // the glyph coverage is sampled as (1, 1, 1, a), so the shader handles it like the RGBA atlas
+    bd->texBuilder.SetSwizzle(nvn::TextureSwizzle::ONE, nvn::TextureSwizzle::ONE, nvn::TextureSwizzle::ONE,
+                              nvn::TextureSwizzle::R);
+#endif
+
+    size_t storageSize = bd->texBuilder.GetStorageSize();
+
+    if (!MemoryArena::Allocate(&bd->fontMemory, storageSize,
+                               nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED,
+                               bd->texBuilder.GetStorageAlignment())) {
+      Logger::log("Failed to Create Font Memory Pool!\n");
+#if IMGUI_XENO_FONT_CACHE
+      FontAtlasCache::close(cacheFile);
+#endif
+      return false;
+    }
+
+    bd->texBuilder.SetStorage(bd->fontMemory.pool, bd->fontMemory.offset);
+
+    if (!bd->fontTexture.Initialize(&bd->texBuilder)) {
+      Logger::log("Failed to Create Font Texture!\n");
+#if IMGUI_XENO_FONT_CACHE
+      FontAtlasCache::close(cacheFile);
+#endif
+      return false;
+    }
+
+#if IMGUI_XENO_FONT_CACHE
+    // the font memory is CPU uncached, so what gets read into it doesn't need flushing
+    if (isCached && !FontAtlasCache::readStorage(cacheFile, bd->fontMemory.cpuPtr, storageSize)) {
+      Logger::log("Failed to Read Font Atlas Cache, Rebuilding it.\n");
+      isCached = false;
+
+      // the restored atlas has no pixels, so this rebuilds it. same key, so the texture size is the same
+      nn::os::Tick rasterizeTick = nn::os::GetSystemTick();
+      getFontTexels(io.Fonts, &pixels, &width, &height);
+      rasterizeMs = getElapsedMs(rasterizeTick);
+    }
+    FontAtlasCache::close(cacheFile);
+#endif
+
+    if (!isCached) {
+      // setup font texture
+
+      nvn::CopyRegion region = {
+          .xoffset = 0,
+          .yoffset = 0,
+          .zoffset = 0,
+          .width = bd->fontTexture.GetWidth(),
+          .height = bd->fontTexture.GetHeight(),
+          .depth = 1
+      };
+
+      bd->fontTexture.WriteTexels(nullptr, &region, pixels);
+      bd->fontTexture.FlushTexels(nullptr, &region);
+
+#if IMGUI_XENO_FONT_CACHE
+      // the storage holds the texels as the GPU reads them now, which is what the cache keeps
+      FontAtlasCache::save(cachePath, cacheKey, io.Fonts, bd->fontMemory.cpuPtr, storageSize);
+#endif
+    }
+
+    // the texel sizes of both formats, the arena rounds the allocation up to a power of two
+    Logger::log("Font Atlas: %dx%d %s, %x bytes of Texture Storage (texels: %x as R8, %x as RGBA8), %s in %.3f ms "
+                "(rasterization: %.3f ms)\n",
+                width, height, IMGUI_XENO_ALPHA8_FONT ? "R8" : "RGBA8", storageSize, width * height, width * height * 4,
+                isCached ? "Loaded from Cache" : "Rasterized and Uploaded", getElapsedMs(startTick), rasterizeMs);
+
+    bd->textureId = 257;
+    bd->texPool.RegisterTexture(bd->textureId, &bd->fontTexture, nullptr);
+
+    bd->fontTexHandle = bd->device->GetTextureHandle(bd->textureId, bd->samplerId);
+    io.Fonts->SetTexID(toTexId(&bd->fontTexHandle));
+
+    return true;
+  }
+
   bool setupFont() {
 
     Logger::log("Setting up ImGui Font.\n");
@@ -284,61 +432,23 @@ namespace ImguiNvnBackend {
 
     int sampMemPoolSize = sampDescSize * MaxSampDescriptors;
     int texMemPoolSize = texDescSize * MaxTexDescriptors;
-    int totalPoolSize = ALIGN_UP(sampMemPoolSize + texMemPoolSize, 0x1000);
-    if (!MemoryPoolMaker::createPool(&bd->sampTexMemPool, totalPoolSize)) {
+    int totalPoolSize = sampMemPoolSize + texMemPoolSize;
+    if (!MemoryArena::Allocate(&bd->sampTexMemory, totalPoolSize)) {
       Logger::log("Failed to Create Texture/Sampler Memory Pool!\n");
       return false;
     }
 
-    if (!bd->samplerPool.Initialize(&bd->sampTexMemPool, 0, MaxSampDescriptors)) {
+    if (!bd->samplerPool.Initialize(bd->sampTexMemory.pool, bd->sampTexMemory.offset, MaxSampDescriptors)) {
       Logger::log("Failed to Create Sampler Pool!\n");
       return false;
     }
 
-    if (!bd->texPool.Initialize(&bd->sampTexMemPool, sampMemPoolSize, MaxTexDescriptors)) {
+    if (!bd->texPool.Initialize(bd->sampTexMemory.pool, bd->sampTexMemory.offset + sampMemPoolSize,
+                                MaxTexDescriptors)) {
       Logger::log("Failed to Create Texture Pool!\n");
       return false;
     }
 
-    // convert imgui font texels
-
-    unsigned char *pixels;
-    int width, height, pixelByteSize;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height, &pixelByteSize);
-    int texPoolSize = pixelByteSize * width * height;
-
-    if (!MemoryPoolMaker::createPool(&bd->fontMemPool, ALIGN_UP(texPoolSize, 0x1000),
-                                     nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED)) {
-      Logger::log("Failed to Create Font Memory Pool!\n");
-      return false;
-    }
-
-    bd->texBuilder.SetDefaults()
-        .SetDevice(bd->device)
-        .SetTarget(nvn::TextureTarget::TARGET_2D)
-        .SetFormat(nvn::Format::RGBA8)
-        .SetSize2D(width, height)
-        .SetStorage(&bd->fontMemPool, 0);
-
-    if (!bd->fontTexture.Initialize(&bd->texBuilder)) {
-      Logger::log("Failed to Create Font Texture!\n");
-      return false;
-    }
-
-    // setup font texture
-
-    nvn::CopyRegion region = {
-        .xoffset = 0,
-        .yoffset = 0,
-        .zoffset = 0,
-        .width = bd->fontTexture.GetWidth(),
-        .height = bd->fontTexture.GetHeight(),
-        .depth = 1
-    };
-
-    bd->fontTexture.WriteTexels(nullptr, &region, pixels);
-    bd->fontTexture.FlushTexels(nullptr, &region);
-
     bd->samplerBuilder.SetDefaults()
         .SetDevice(bd->device)
         .SetMinMagFilter(nvn::MinFilter::LINEAR, nvn::MagFilter::LINEAR)
@@ -349,192 +459,1190 @@ namespace ImguiNvnBackend {
       return false;
     }
 
-    bd->textureId = 257;
     bd->samplerId = 257;
-
-    bd->texPool.RegisterTexture(bd->textureId, &bd->fontTexture, nullptr);
     bd->samplerPool.RegisterSampler(bd->samplerId, &bd->fontSampler);
 
-    bd->fontTexHandle = bd->device->GetTextureHandle(bd->textureId, bd->samplerId);
-    io.Fonts->SetTexID(&bd->fontTexHandle);
+    for (int id = MaxTexDescriptors - 1; id >= FirstDynamicTexId; id--) {
+      bd->freeTexIds.push_back(id);
+    }
+    nn::os::InitializeMutex(&bd->textureMutex, true, 0);
+
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+    // the atlas texture gets created by updateTextures, once ImGui has rasterized the first glyphs
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    io.Fonts->TexDesiredFormat = IMGUI_XENO_ALPHA8_FONT ? ImTextureFormat_Alpha8 : ImTextureFormat_RGBA32;
+    io.Fonts->TexMinWidth = io.Fonts->TexMaxWidth = IMGUI_XENO_FONT_ATLAS_SIZE;
+    io.Fonts->TexMinHeight = io.Fonts->TexMaxHeight = IMGUI_XENO_FONT_ATLAS_SIZE;
+#else
+    // the static atlas gets baked by setupFontTexture, once the init callbacks have added their fonts
+    (void) io;
+#endif
 
     Logger::log("Finished.\n");
 
     return true;
   }
 
-  bool setupShaders(u8 *shaderBinary, ulong binarySize) {
-
-    Logger::log("Setting up ImGui Shaders.\n");
+  // hands out the lowest free descriptor slot, -1 if every slot is taken
+  int allocTextureId() {
 
     auto bd = getBackendData();
 
-    if (!bd->shaderProgram.Initialize(bd->device)) {
-      Logger::log("Failed to Initialize Shader Program!");
-      return false;
+    nn::os::LockMutex(&bd->textureMutex);
+    int id = -1;
+    if (!bd->freeTexIds.empty()) {
+      id = bd->freeTexIds.back();
+      bd->freeTexIds.pop_back();
     }
+    nn::os::UnlockMutex(&bd->textureMutex);
 
-    bd->shaderMemory = IM_NEW(MemoryBuffer)(binarySize, shaderBinary, nvn::MemoryPoolFlags::CPU_UNCACHED |
-                                                                      nvn::MemoryPoolFlags::GPU_CACHED |
-                                                                      nvn::MemoryPoolFlags::SHADER_CODE);
+    if (id < 0) {
+      Logger::log("Out of Texture Descriptors!\n");
+    }
 
-    if (!bd->shaderMemory->IsBufferReady()) {
-      Logger::log("Shader Memory Pool not Ready! Unable to continue.\n");
-      return false;
+    return id;
+  }
+
+  // the slot must not be sampled by any frame the GPU hasn't finished yet
+  void freeTextureId(int id) {
+
+    auto bd = getBackendData();
+
+    nn::os::LockMutex(&bd->textureMutex);
+    // kept sorted from highest to lowest, so slots get reused from the bottom
+    int idx = bd->freeTexIds.Size;
+    while (idx > 0 && bd->freeTexIds[idx - 1] < id) {
+      idx--;
     }
+    bd->freeTexIds.insert(bd->freeTexIds.Data + idx, id);
+    nn::os::UnlockMutex(&bd->textureMutex);
+  }
 
-    BinaryHeader offsetData = BinaryHeader((u32 *) shaderBinary);
+  // reserves contiguous ring space, fails if the GPU hasn't released enough of it yet.
+  // the texture mutex must be locked
+  bool allocateStaging(size_t size, u64 *pos) {
 
-    nvn::BufferAddress addr = bd->shaderMemory->GetBufferAddress();
+    StagingRing &ring = getBackendData()->stagingRing;
 
-    nvn::ShaderData &vertShaderData = bd->shaderDatas[0];
-    vertShaderData.data = addr + offsetData.mVertexDataOffset;
-    vertShaderData.control = shaderBinary + offsetData.mVertexControlOffset;
+    if (!ring.memory->IsBufferReady() || size > StagingSize) {
+      return false;
+    }
 
-    nvn::ShaderData &fragShaderData = bd->shaderDatas[1];
-    fragShaderData.data = addr + offsetData.mFragmentDataOffset;
-    fragShaderData.control = shaderBinary + offsetData.mFragmentControlOffset;
+    // copies read their rows from a single range, so it can't wrap around the end of the ring
+    u64 start = ALIGN_UP(ring.writePos, StagingAlignment);
+    u64 offset = start % StagingSize;
+    if (offset + size > StagingSize) {
+      start += StagingSize - offset;
+    }
 
-    if (!bd->shaderProgram.SetShaders(2, bd->shaderDatas)) {
-      Logger::log("Failed to Set shader data for program.\n");
+    if (start + size - ring.releasePos > StagingSize) {
       return false;
     }
 
-    bd->shaderProgram.SetDebugLabel("ImGuiShader");
+    ring.writePos = start + size;
+    *pos = start;
+    return true;
+  }
 
-    // Uniform Block Object Memory Setup
+  // forgets the updates of a texture that haven't been recorded yet, before it gets destroyed.
+  // the texture mutex must be locked
+  void dropStagedUploads(const nvn::Texture *texture) {
 
-    bd->uniformMemory = IM_NEW(MemoryBuffer)(UBOSIZE);
+    StagingRing &ring = getBackendData()->stagingRing;
 
-    if (!bd->uniformMemory->IsBufferReady()) {
-      Logger::log("Uniform Memory Pool not Ready! Unable to continue.\n");
-      return false;
+    for (int i = ring.uploads.Size - 1; i >= 0; i--) {
+      if (ring.uploads[i].texture == texture) {
+        ring.uploads.erase(ring.uploads.Data + i);
+      }
     }
+  }
 
-    // setup vertex attrib & stream
-
-    bd->attribStates[0].SetDefaults().SetFormat(nvn::Format::RG32F, offsetof(ImDrawVert, pos)); // pos
-    bd->attribStates[1].SetDefaults().SetFormat(nvn::Format::RG32F, offsetof(ImDrawVert, uv)); // uv
-    bd->attribStates[2].SetDefaults().SetFormat(nvn::Format::RGBA8, offsetof(ImDrawVert, col)); // color
+  // writes the updates of a texture that haven't been recorded yet straight from the ring, and forgets them. a direct
+  // write that follows can't be overwritten by their copies that way. the texture mutex must be locked
+  void writeStagedUploads(const nvn::Texture *texture) {
 
-    bd->streamState.SetDefaults().SetStride(sizeof(ImDrawVert));
+    StagingRing &ring = getBackendData()->stagingRing;
 
-    Logger::log("Finished.\n");
+    for (int i = 0; i < ring.uploads.Size;) {
+      TextureUpload &upload = ring.uploads[i];
+      if (upload.texture != texture) {
+        i++;
+        continue;
+      }
 
-    return true;
+      texture->WriteTexelsStrided(nullptr, &upload.region, ring.memory->GetMemPtr() + upload.pos % StagingSize,
+                                  upload.rowPitch, 0);
+      texture->FlushTexels(nullptr, &upload.region);
+      ring.uploads.erase(ring.uploads.Data + i);
+    }
   }
 
-  void InitBackend(const NvnBackendInitInfo &initInfo) {
-    ImGuiIO &io = ImGui::GetIO();
-    XENO_ASSERT(!io.BackendRendererUserData, "Already Initialized Imgui Backend!");
+  // copies rows of texels into the staging ring, and queues their copy into the texture for the next recorded frame.
+  // rowSize is the size of a row without padding (a row of blocks for compressed formats)
+  bool stageTexels(const nvn::Texture *texture, const nvn::CopyRegion &region, const void *data, ptrdiff_t srcPitch,
+                   size_t rowSize, int rows) {
 
-    io.BackendPlatformName = "Switch";
-    io.BackendRendererName = "imgui_impl_nvn";
-    io.IniFilename = nullptr;
-    io.MouseDrawCursor = true;
-    io.ConfigFlags |= ImGuiConfigFlags_IsTouchScreen;
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
-    io.BackendFlags |= ImGuiBackendFlags_HasGamepad;
-    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    auto bd = getBackendData();
+    StagingRing &ring = bd->stagingRing;
 
-    io.DisplaySize = ImVec2(IMGUI_XENO_VIEWPORT_WIDTH, IMGUI_XENO_VIEWPORT_HEIGHT); // default size
+    nn::os::LockMutex(&bd->textureMutex);
 
-    // calculate ortho matrix
-    orthoRH_ZO(projMatrix, 0.0f, io.DisplaySize.x, io.DisplaySize.y, 0.0f, -1.0f, 1.0f);
+    u64 pos = 0;
+    bool isStaged = allocateStaging(rowSize * rows, &pos);
+    if (isStaged) {
+      u8 *dst = ring.memory->GetMemPtr() + pos % StagingSize;
+      auto src = (const u8 *) data;
+      for (int i = 0; i < rows; i++) {
+        memcpy(dst + i * rowSize, src + i * srcPitch, rowSize);
+      }
 
-    auto *bd = IM_NEW(NvnBackendData)();
-    io.BackendRendererUserData = (void *) bd;
+      ring.uploads.push_back({
+          .texture = texture,
+          .region = region,
+          .pos = pos,
+          .rowPitch = (ptrdiff_t) rowSize
+      });
+    } else {
+      // space is only released once a frame's slot gets acquired again, which replaying an unchanged frame never does
+      bd->isRecordedFrameStale = true;
+      if (ring.overflows++ % 64 == 0) {
+        Logger::log("Staging Ring is Full! (overflows: %d)\n", ring.overflows);
+      }
+    }
 
-    bd->device = initInfo.device;
-    bd->queue = initInfo.queue;
-    bd->cmdBuf = initInfo.cmdBuf;
-    bd->isInitialized = false;
+    nn::os::UnlockMutex(&bd->textureMutex);
 
-#if IMGUI_XENO_LOAD_DEFAULT_FONT
-    io.Fonts->AddFontFromMemoryCompressedTTF(
-        JetBrainsMonoNL_compressed_data, JetBrainsMonoNL_compressed_size,
-        18.f
-    );
-#endif
+    return isStaged;
+  }
 
-    if (createShaders()) {
-      Logger::log("Shader Binaries Loaded! Setting up Render Data.\n");
+  // records the copies staged since the last frame, and invalidates the texture caches if the CPU wrote to any texture,
+  // before anything samples them
+  void recordTextureUploads(FrameResources &frame) {
 
-      if (bd->isUseTestShader)
-        initTestShader();
+    auto bd = getBackendData();
+    StagingRing &ring = bd->stagingRing;
 
-      if (setupShaders(bd->imguiShaderBinary.ptr, bd->imguiShaderBinary.size) && setupFont()) {
-        Logger::log("Rendering Setup!\n");
+    nn::os::LockMutex(&bd->textureMutex);
 
-        bd->isInitialized = true;
+    if (!ring.uploads.empty()) {
+      // frames before this one might still be sampling the texels being replaced
+      bd->cmdBuf->Barrier(nvn::BarrierBits::ORDER_FRAGMENTS);
 
-      } else {
-        Logger::log("Failed to Setup Render Data!\n");
+      nvn::BufferAddress base = ring.memory->GetBufferAddress();
+      for (auto &upload: ring.uploads) {
+        bd->cmdBuf->SetCopyRowStride(upload.rowPitch);
+        bd->cmdBuf->CopyBufferToTexture(base + upload.pos % StagingSize, upload.texture, nullptr, &upload.region,
+                                        nvn::CopyFlags::NONE);
       }
+      bd->cmdBuf->SetCopyRowStride(0);
+
+      bd->cmdBuf->Barrier(nvn::BarrierBits::ORDER_PRIMITIVES | nvn::BarrierBits::INVALIDATE_TEXTURE);
+
+      ring.uploads.resize(0);
+      ring.flushedPos = ring.writePos;
     }
-  }
+    frame.stagingEnd = ring.flushedPos;
 
-  void ShutdownBackend() {
+    if (bd->hasTextureWrites) {
+      // texels and descriptors written by the CPU might still be cached from before
+      bd->cmdBuf->Barrier(nvn::BarrierBits::INVALIDATE_TEXTURE | nvn::BarrierBits::INVALIDATE_TEXTURE_DESCRIPTOR);
+      bd->hasTextureWrites = false;
+    }
 
+    nn::os::UnlockMutex(&bd->textureMutex);
   }
 
-  bool updateTouch(ImGuiIO &io) {
-    ImVec2 pos(0, 0);
-    if (!InputHelper::getTouchCoords(&pos.x, &pos.y)) {
-      if (InputHelper::isTouchRelease()) {
-        io.AddMouseButtonEvent(ImGuiMouseButton_Left, false);
-      }
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+  bool createManagedTexture(ImTextureData *tex) {
+
+    auto bd = getBackendData();
+
+    bool isAlpha8 = tex->Format == ImTextureFormat_Alpha8;
+
+    bd->texBuilder.SetDefaults()
+        .SetDevice(bd->device)
+        .SetTarget(nvn::TextureTarget::TARGET_2D)
+        .SetFormat(isAlpha8 ? nvn::Format::R8 : nvn::Format::RGBA8)
+        .SetSize2D(tex->Width, tex->Height);
+
+    if (isAlpha8) {
+      bd->texBuilder.SetSwizzle(nvn::TextureSwizzle::ONE, nvn::TextureSwizzle::ONE, nvn::TextureSwizzle::ONE,
+                                nvn::TextureSwizzle::R);
+    }
+
+    auto *managed = IM_NEW(ManagedTexture)();
+
+    if (!MemoryArena::Allocate(&managed->memory, bd->texBuilder.GetStorageSize(),
+                               nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED,
+                               bd->texBuilder.GetStorageAlignment())) {
+      Logger::log("Failed to Allocate Texture Memory!\n");
+      IM_DELETE(managed);
       return false;
     }
 
-    io.AddMouseSourceEvent(ImGuiMouseSource_TouchScreen);
+    bd->texBuilder.SetStorage(managed->memory.pool, managed->memory.offset);
 
-    pos.x = (pos.x / (float) IMGUI_XENO_VIEWPORT_WIDTH) * io.DisplaySize.x;
-    pos.y = (pos.y / (float) IMGUI_XENO_VIEWPORT_HEIGHT) * io.DisplaySize.y;
-    io.AddMousePosEvent(pos.x, pos.y);
+    if (!managed->texture.Initialize(&bd->texBuilder)) {
+      Logger::log("Failed to Create Texture!\n");
+      MemoryArena::Free(managed->memory);
+      IM_DELETE(managed);
+      return false;
+    }
 
-    if (InputHelper::isTouchPress()) {
-      io.AddMouseButtonEvent(ImGuiMouseButton_Left, true);
+    managed->textureId = allocTextureId();
+    if (managed->textureId < 0) {
+      managed->texture.Finalize();
+      MemoryArena::Free(managed->memory);
+      IM_DELETE(managed);
+      return false;
     }
-    return true;
-  }
 
-  void updateMouse(ImGuiIO &io) {
-    ImVec2 mousePos(0, 0);
-    InputHelper::getMouseCoords(&mousePos.x, &mousePos.y);
+    bd->texPool.RegisterTexture(managed->textureId, &managed->texture, nullptr);
+    managed->texHandle = bd->device->GetTextureHandle(managed->textureId, bd->samplerId);
 
-    io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
+    tex->BackendUserData = managed;
+    tex->SetTexID(toTexId(&managed->texHandle));
 
-    // Workaround from https://github.com/Amethyst-szs/smo-lunakit
-    mousePos = ImVec2((mousePos.x / (float) IMGUI_XENO_VIEWPORT_WIDTH) * io.DisplaySize.x,
-                      (mousePos.y / (float) IMGUI_XENO_VIEWPORT_HEIGHT) * io.DisplaySize.y);
-    io.AddMousePosEvent(mousePos.x, mousePos.y);
+    Logger::log("Created %dx%d %s Texture: %x bytes of Texture Memory\n", tex->Width, tex->Height,
+                isAlpha8 ? "R8" : "RGBA8", managed->memory.size);
 
-    ImVec2 scrollDelta(0, 0);
-    InputHelper::getScrollDelta(&scrollDelta.x, &scrollDelta.y);
+    return true;
+  }
 
-    if (scrollDelta.x != 0.0f)
-      io.AddMouseWheelEvent(0.0f, scrollDelta.x > 0.0f ? 0.5f : -0.5f);
+  void destroyManagedTexture(ImTextureData *tex) {
 
-    for (auto [im_k, nx_k]: mouse_mapping) {
-      if (InputHelper::isMousePress((nn::hid::MouseButton) nx_k))
-        io.AddMouseButtonEvent((ImGuiMouseButton) im_k, true);
-      else if (InputHelper::isMouseRelease((nn::hid::MouseButton) nx_k))
-        io.AddMouseButtonEvent((ImGuiMouseButton) im_k, false);
-    }
-  }
+    if (auto *managed = (ManagedTexture *) tex->BackendUserData) {
+      // a frame that returned early might have left updates behind
+      auto bd = getBackendData();
+      nn::os::LockMutex(&bd->textureMutex);
+      dropStagedUploads(&managed->texture);
+      nn::os::UnlockMutex(&bd->textureMutex);
 
-  void updateKeyboard(ImGuiIO &io) {
-    for (auto [im_k, nx_k]: key_mapping) {
-      if (InputHelper::isKeyPress((nn::hid::KeyboardKey) nx_k)) {
-        io.AddKeyEvent((ImGuiKey) im_k, true);
-      } else if (InputHelper::isKeyRelease((nn::hid::KeyboardKey) nx_k)) {
-        io.AddKeyEvent((ImGuiKey) im_k, false);
-      }
+      managed->texture.Finalize();
+      MemoryArena::Free(managed->memory);
+      freeTextureId(managed->textureId);
+      IM_DELETE(managed);
     }
+
+    tex->BackendUserData = nullptr;
+    tex->SetTexID(ImTextureID_Invalid);
+    tex->SetStatus(ImTextureStatus_Destroyed);
   }
 
-  void updateGamepad(ImGuiIO &io) {
+  // the rectangle is read straight out of ImGui's pixels, using their row pitch. updates of a texture already in use
+  // go through the staging ring, a new texture can't be sampled yet so it gets written directly.
+  // if the ring is full, the GPU is waited on first: the ring only holds this frame's updates after that, and no frame
+  // samples the texture anymore, so the texture's queued updates and then this one can be written directly in order
+  size_t uploadTextureRect(ImTextureData *tex, const ImTextureRect &rect, bool isNewTexture) {
+
+    auto *managed = (ManagedTexture *) tex->BackendUserData;
+
+    nvn::CopyRegion region = {
+        .xoffset = rect.x,
+        .yoffset = rect.y,
+        .zoffset = 0,
+        .width = rect.w,
+        .height = rect.h,
+        .depth = 1
+    };
+
+    const void *pixels = tex->GetPixelsAt(rect.x, rect.y);
+    size_t rowSize = (size_t) rect.w * tex->BytesPerPixel;
+    bool isStaged = !isNewTexture && stageTexels(&managed->texture, region, pixels, tex->GetPitch(), rowSize, rect.h);
+    if (!isStaged && !isNewTexture) {
+      waitForFrames();
+      isStaged = stageTexels(&managed->texture, region, pixels, tex->GetPitch(), rowSize, rect.h);
+    }
+
+    if (!isStaged) {
+      auto bd = getBackendData();
+      nn::os::LockMutex(&bd->textureMutex);
+      writeStagedUploads(&managed->texture);
+      nn::os::UnlockMutex(&bd->textureMutex);
+
+      managed->texture.WriteTexelsStrided(nullptr, &region, pixels, tex->GetPitch(), 0);
+      managed->texture.FlushTexels(nullptr, &region);
+    }
+
+    return (size_t) rect.w * rect.h * tex->BytesPerPixel;
+  }
+
+  void updateTextures(ImDrawData *drawData) {
+
+    if (!drawData->Textures) {
+      return;
+    }
+
+    auto bd = getBackendData();
+
+    nn::os::Tick startTick = nn::os::GetSystemTick();
+    size_t uploadedSize = 0;
+
+    for (ImTextureData *tex: *drawData->Textures) {
+      switch (tex->Status) {
+        case ImTextureStatus_WantCreate: {
+          if (!createManagedTexture(tex)) {
+            break;
+          }
+
+          ImTextureRect fullRect = {0, 0, (unsigned short) tex->Width, (unsigned short) tex->Height};
+          uploadedSize += uploadTextureRect(tex, fullRect, true);
+          tex->SetStatus(ImTextureStatus_OK);
+          break;
+        }
+        case ImTextureStatus_WantUpdates:
+          for (auto &rect: tex->Updates) {
+            uploadedSize += uploadTextureRect(tex, rect, false);
+          }
+          tex->SetStatus(ImTextureStatus_OK);
+          break;
+        case ImTextureStatus_WantDestroy:
+          // frames still in flight might sample it, ImGui keeps asking until it's destroyed
+          if (tex->UnusedFrames >= FramesInFlight) {
+            destroyManagedTexture(tex);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (uploadedSize > 0) {
+      nn::os::LockMutex(&bd->textureMutex);
+      bd->hasTextureWrites = true;
+      nn::os::UnlockMutex(&bd->textureMutex);
+
+      // a replayed frame wouldn't copy the staged texels
+      invalidateRecordedFrame();
+      Logger::log("Uploaded %x bytes of Texels in %.3f ms\n", uploadedSize, getElapsedMs(startTick));
+    }
+  }
+#endif
+
+  struct UserTextureFormatInfo {
+    nvn::Format::Enum format;
+    // texels per side of a block, and bytes per block
+    int blockSize;
+    int blockBytes;
+  };
+
+  // indexed by ImguiXenoTextureFormat
+  static constexpr UserTextureFormatInfo UserTextureFormats[] = {
+      {nvn::Format::RGBA8, 1, 4},
+      {nvn::Format::RGBA_DXT1, 4, 8},
+      {nvn::Format::RGBA_DXT5, 4, 16},
+      {nvn::Format::BPTC_UNORM, 4, 16},
+  };
+
+  // handles keep the entry's generation in their upper bits, and its index + 1 in the lower ones
+  ImguiXenoTexture makeUserTextureHandle(int index) {
+    return (ImguiXenoTexture) getBackendData()->userTextures[index].generation << 16 | (ImguiXenoTexture) (index + 1);
+  }
+
+  // the entry of a live texture, nullptr if the handle is invalid or the texture was destroyed.
+  // the texture mutex must be locked
+  UserTexture *findUserTexture(ImguiXenoTexture handle) {
+
+    auto bd = getBackendData();
+
+    int index = (int) (handle & 0xFFFF) - 1;
+    if (index < 0 || index >= MaxUserTextures) {
+      return nullptr;
+    }
+
+    UserTexture &entry = bd->userTextures[index];
+    if (!entry.isUsed || entry.isPendingFree || entry.generation != (u16) (handle >> 16)) {
+      return nullptr;
+    }
+
+    return &entry;
+  }
+
+  // streamed texels go through the staging ring, and fail if it is full: frames in flight might still sample the
+  // texture, and the updates queued before this one would overwrite a direct write. textures that can't be sampled
+  // yet are written directly
+  bool writeUserTexels(UserTexture &entry, int x, int y, int width, int height, const void *data, int pitch,
+                       bool isStreamed) {
+
+    const UserTextureFormatInfo &info = UserTextureFormats[entry.format];
+
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > entry.width || y + height > entry.height ||
+        x % info.blockSize || y % info.blockSize || width % info.blockSize || height % info.blockSize) {
+      Logger::log("Invalid Texture Region! x: %d y: %d w: %d h: %d\n", x, y, width, height);
+      return false;
+    }
+
+    nvn::CopyRegion region = {
+        .xoffset = x,
+        .yoffset = y,
+        .zoffset = 0,
+        .width = width,
+        .height = height,
+        .depth = 1
+    };
+
+    size_t rowSize = (size_t) (width / info.blockSize) * info.blockBytes;
+    ptrdiff_t rowPitch = pitch > 0 ? pitch : (ptrdiff_t) rowSize;
+
+    if (isStreamed) {
+      return stageTexels(&entry.texture, region, data, rowPitch, rowSize, height / info.blockSize);
+    }
+
+    entry.texture.WriteTexelsStrided(nullptr, &region, data, rowPitch, 0);
+    entry.texture.FlushTexels(nullptr, &region);
+    return true;
+  }
+
+  ImguiXenoTexture createUserTexture(int width, int height, ImguiXenoTextureFormat format, const void *data) {
+
+    auto bd = getBackendData();
+
+    if (format < 0 || format >= IM_ARRAYSIZE(UserTextureFormats) || width <= 0 || height <= 0 ||
+        width % UserTextureFormats[format].blockSize || height % UserTextureFormats[format].blockSize) {
+      Logger::log("Invalid Texture! Size: %dx%d Format: %d\n", width, height, format);
+      return 0;
+    }
+
+    nn::os::LockMutex(&bd->textureMutex);
+
+    int index = 0;
+    while (index < MaxUserTextures && bd->userTextures[index].isUsed) {
+      index++;
+    }
+    if (index == MaxUserTextures) {
+      Logger::log("Out of User Textures! Cannot Create Texture.\n");
+      nn::os::UnlockMutex(&bd->textureMutex);
+      return 0;
+    }
+
+    UserTexture &entry = bd->userTextures[index];
+
+    // the backend's builder is used by the render thread, textures can be created from anywhere
+    nvn::TextureBuilder builder;
+    builder.SetDefaults()
+        .SetDevice(bd->device)
+        .SetTarget(nvn::TextureTarget::TARGET_2D)
+        .SetFormat(UserTextureFormats[format].format)
+        .SetSize2D(width, height);
+
+    if (!MemoryArena::Allocate(&entry.memory, builder.GetStorageSize(),
+                               nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED,
+                               builder.GetStorageAlignment())) {
+      Logger::log("Failed to Allocate Texture Memory!\n");
+      nn::os::UnlockMutex(&bd->textureMutex);
+      return 0;
+    }
+
+    builder.SetStorage(entry.memory.pool, entry.memory.offset);
+
+    if (!entry.texture.Initialize(&builder)) {
+      Logger::log("Failed to Create Texture!\n");
+      MemoryArena::Free(entry.memory);
+      nn::os::UnlockMutex(&bd->textureMutex);
+      return 0;
+    }
+
+    entry.textureId = allocTextureId();
+    if (entry.textureId < 0) {
+      entry.texture.Finalize();
+      MemoryArena::Free(entry.memory);
+      nn::os::UnlockMutex(&bd->textureMutex);
+      return 0;
+    }
+
+    bd->texPool.RegisterTexture(entry.textureId, &entry.texture, nullptr);
+    entry.texHandle = bd->device->GetTextureHandle(entry.textureId, bd->samplerId);
+    entry.width = width;
+    entry.height = height;
+    entry.format = format;
+    entry.isUsed = true;
+    entry.isPendingFree = false;
+    entry.lastUseSerial = 0;
+
+    if (data) {
+      writeUserTexels(entry, 0, 0, width, height, data, 0, false);
+    }
+    bd->hasTextureWrites = true;
+
+    ImguiXenoTexture handle = makeUserTextureHandle(index);
+    nn::os::UnlockMutex(&bd->textureMutex);
+
+    Logger::log("Created %dx%d User Texture %x in Slot %d: %x bytes of Texture Memory\n", width, height, handle,
+                entry.textureId, entry.memory.size);
+
+    return handle;
+  }
+
+  bool updateUserTexture(ImguiXenoTexture handle, int x, int y, int width, int height, const void *data, int pitch) {
+
+    auto bd = getBackendData();
+
+    nn::os::LockMutex(&bd->textureMutex);
+
+    UserTexture *entry = findUserTexture(handle);
+    bool isUpdated = entry && writeUserTexels(*entry, x, y, width, height, data, pitch, true);
+    if (isUpdated) {
+      bd->hasTextureWrites = true;
+      // the draw data might not change with the texture, and a replayed frame wouldn't copy the staged texels
+      bd->isOverlayCacheStale = true;
+      bd->isRecordedFrameStale = true;
+    }
+
+    nn::os::UnlockMutex(&bd->textureMutex);
+
+    if (!entry) {
+      Logger::log("Cannot Update Texture %x! It doesn't Exist.\n", handle);
+    }
+
+    return isUpdated;
+  }
+
+  void destroyUserTexture(ImguiXenoTexture handle) {
+
+    auto bd = getBackendData();
+
+    nn::os::LockMutex(&bd->textureMutex);
+
+    if (UserTexture *entry = findUserTexture(handle)) {
+      // draw data built before this can still get recorded by the next few frames (e.g. with async frames), drawing
+      // it again afterwards pushes lastUseSerial further
+      entry->isPendingFree = true;
+      if (entry->lastUseSerial < bd->submittedFrames + FramesInFlight) {
+        entry->lastUseSerial = bd->submittedFrames + FramesInFlight;
+      }
+    }
+
+    nn::os::UnlockMutex(&bd->textureMutex);
+
+    // the recorded frame might sample it, and replays don't keep it alive
+    invalidateRecordedFrame();
+  }
+
+  const nvn::TextureHandle *getUserTextureHandle(ImguiXenoTexture handle) {
+
+    auto bd = getBackendData();
+
+    nn::os::LockMutex(&bd->textureMutex);
+    UserTexture *entry = findUserTexture(handle);
+    nn::os::UnlockMutex(&bd->textureMutex);
+
+    return entry ? &entry->texHandle : nullptr;
+  }
+
+  // frees the destroyed textures and the staging space the GPU is done with, called once a frame's fence has been
+  // waited on
+  void releaseTextureResources(const FrameResources &frame) {
+
+    auto bd = getBackendData();
+    StagingRing &ring = bd->stagingRing;
+
+    nn::os::LockMutex(&bd->textureMutex);
+
+    if (frame.stagingEnd > ring.releasePos) {
+      ring.releasePos = frame.stagingEnd;
+    }
+
+    for (auto &entry: bd->userTextures) {
+      if (entry.isPendingFree && entry.lastUseSerial <= bd->completedFrames) {
+        // updates staged after the last recorded frame
+        dropStagedUploads(&entry.texture);
+
+        entry.texture.Finalize();
+        MemoryArena::Free(entry.memory);
+        freeTextureId(entry.textureId);
+        entry.generation++;
+        entry.isUsed = false;
+        entry.isPendingFree = false;
+      }
+    }
+
+    nn::os::UnlockMutex(&bd->textureMutex);
+  }
+
+  // keeps user textures alive until the GPU is done with the last frame drawing them. texture IDs pointing into the
+  // user textures are the only ones that need tracking
+  void markUserTextureUse(const nvn::TextureHandle *texHandle) {
+
+    auto bd = getBackendData();
+
+    uintptr_t offset = (uintptr_t) texHandle - (uintptr_t) bd->userTextures;
+    if (offset < sizeof(bd->userTextures)) {
+      nn::os::LockMutex(&bd->textureMutex);
+      bd->userTextures[offset / sizeof(UserTexture)].lastUseSerial = bd->submittedFrames + 1;
+      nn::os::UnlockMutex(&bd->textureMutex);
+    }
+  }
+
+  bool setupFrameResources() {
+
+    Logger::log("Setting up %d Frame(s) of Streaming Data.\n", FramesInFlight);
+
+    auto bd = getBackendData();
+
+    for (auto &frame: bd->frames) {
+      if (!frame.fence.Initialize(bd->device)) {
+        Logger::log("Failed to Initialize Frame Fence!\n");
+        return false;
+      }
+      frame.isFenceSubmitted = false;
+
+      // begin/end timestamps of the frame's commands
+      frame.timestampBuffer = IM_NEW(MemoryBuffer)(sizeof(nvn::CounterData) * 2);
+      if (!frame.timestampBuffer->IsBufferReady()) {
+        Logger::log("Failed to Create Timestamp Buffer!\n");
+        return false;
+      }
+      frame.hasTimestamps = false;
+    }
+
+    bd->frameIndex = 0;
+
+    // allocated here rather than by the first texture update, which can come from any thread. updates get written
+    // directly to their texture if it fails
+    StagingRing &ring = bd->stagingRing;
+    ring.memory = IM_NEW(MemoryBuffer)(StagingSize);
+    if (ring.memory->IsBufferReady()) {
+      Logger::log("Allocated Staging Ring. Size: %x\n", StagingSize);
+    } else {
+      Logger::log("Failed to Create Staging Ring!\n");
+    }
+
+    Logger::log("Finished.\n");
+
+    return true;
+  }
+
+  FrameResources &acquireFrame() {
+
+    auto bd = getBackendData();
+    FrameResources &frame = bd->frames[bd->frameIndex];
+
+    // only blocks if the GPU is still FramesInFlight frames behind us, which should almost never happen
+    if (frame.isFenceSubmitted) {
+      nvn::SyncWaitResult result = frame.fence.Wait(UINT64_MAX);
+      if (result == nvn::SyncWaitResult::FAILED) {
+        Logger::log("Failed to Wait on Frame Fence!\n");
+      }
+      frame.isFenceSubmitted = false;
+    }
+    // waitForFrames might have already marked it done
+    if (frame.serial > bd->completedFrames) {
+      bd->completedFrames = frame.serial;
+    }
+
+    releaseTextureResources(frame);
+
+    // the GPU is done with this frame, so the timestamps it wrote can be read back
+    if (frame.hasTimestamps) {
+      auto counters = (nvn::CounterData *) frame.timestampBuffer->GetMemPtr();
+      uint64_t beginNs = bd->device->GetTimestampInNanoseconds(&counters[0]);
+      uint64_t endNs = bd->device->GetTimestampInNanoseconds(&counters[1]);
+      bd->gpuMs = (float) (endNs - beginNs) / 1e6f;
+      frame.hasTimestamps = false;
+    }
+
+    return frame;
+  }
+
+  void releaseFrame(FrameResources &frame) {
+
+    auto bd = getBackendData();
+
+    // signals once every command submitted so far (including this frame's draws) has completed
+    bd->queue->FenceSync(&frame.fence, nvn::SyncCondition::ALL_GPU_COMMANDS_COMPLETE,
+                         nvn::SyncFlagBits::FLUSH_FOR_CPU);
+    frame.isFenceSubmitted = true;
+
+    // destroyUserTexture reads it from other threads
+    nn::os::LockMutex(&bd->textureMutex);
+    frame.serial = ++bd->submittedFrames;
+    nn::os::UnlockMutex(&bd->textureMutex);
+
+    bd->frameIndex = (bd->frameIndex + 1) % FramesInFlight;
+  }
+
+  bool allocateCommandBlock(CommandMemory &memory, size_t size) {
+
+    auto bd = getBackendData();
+
+    MemoryArena::Allocation block = {};
+    if (!MemoryArena::Allocate(&block, ALIGN_UP(size, bd->cmdMemAlignment),
+                               nvn::MemoryPoolFlags::CPU_UNCACHED | nvn::MemoryPoolFlags::GPU_CACHED,
+                               bd->cmdMemAlignment)) {
+      Logger::log("Failed to Allocate Command Memory! Size: %x\n", size);
+      return false;
+    }
+
+    memory.commandBlocks.push_back(block);
+    memory.commandSize += block.size;
+    return true;
+  }
+
+  bool allocateControlBlock(CommandMemory &memory, size_t size) {
+
+    auto bd = getBackendData();
+
+    size = ALIGN_UP(size, bd->ctrlMemAlignment);
+    void *block = Mem::AllocateAlign(bd->ctrlMemAlignment, size);
+    if (!block) {
+      Logger::log("Failed to Allocate Control Memory! Size: %x\n", size);
+      return false;
+    }
+
+    memory.controlBlocks.push_back({block, size});
+    memory.controlSize += size;
+    return true;
+  }
+
+  // called by NVN while recording, whenever the block it's writing to runs out. adds a block at least as big as
+  // everything the frame has used so far, so a growing overlay only needs a few of these
+  void onCommandMemoryEvent(nvn::CommandBuffer *cmdBuf, nvn::CommandBufferMemoryEvent::Enum event, size_t minSize,
+                            void *callbackData) {
+
+    auto &memory = *(CommandMemory *) callbackData;
+
+    if (event == nvn::CommandBufferMemoryEvent::OUT_OF_COMMAND_MEMORY) {
+      if (allocateCommandBlock(memory, memory.commandSize > minSize ? memory.commandSize : minSize)) {
+        auto &block = memory.commandBlocks.back();
+        cmdBuf->AddCommandMemory(block.pool, block.offset, block.size);
+      }
+    } else if (event == nvn::CommandBufferMemoryEvent::OUT_OF_CONTROL_MEMORY) {
+      if (allocateControlBlock(memory, memory.controlSize > minSize ? memory.controlSize : minSize)) {
+        auto &block = memory.controlBlocks.back();
+        cmdBuf->AddControlMemory(block.ptr, block.size);
+      }
+    }
+  }
+
+  bool setupCommandBuffer() {
+
+    Logger::log("Setting up Command Buffer.\n");
+
+    auto bd = getBackendData();
+
+    if (!bd->commandBuffer.Initialize(bd->device)) {
+      Logger::log("Failed to Initialize Command Buffer!\n");
+      return false;
+    }
+
+    bd->cmdBuf = &bd->commandBuffer;
+    bd->cmdBuf->SetMemoryCallback(onCommandMemoryEvent);
+
+    int cmdAlignment = 0, ctrlAlignment = 0;
+    bd->device->GetInteger(nvn::DeviceInfo::COMMAND_BUFFER_COMMAND_ALIGNMENT, &cmdAlignment);
+    bd->device->GetInteger(nvn::DeviceInfo::COMMAND_BUFFER_CONTROL_ALIGNMENT, &ctrlAlignment);
+    bd->cmdMemAlignment = cmdAlignment;
+    bd->ctrlMemAlignment = ctrlAlignment;
+
+    int minCmdSize = 0, minCtrlSize = 0;
+    bd->device->GetInteger(nvn::DeviceInfo::COMMAND_BUFFER_MIN_COMMAND_SIZE, &minCmdSize);
+    bd->device->GetInteger(nvn::DeviceInfo::COMMAND_BUFFER_MIN_CONTROL_SIZE, &minCtrlSize);
+
+    // every frame in flight records into memory of its own, so a recording stays valid until its fence signals
+    for (auto &frame: bd->frames) {
+      if (!allocateCommandBlock(frame.cmdMemory, CommandMemorySize > (size_t) minCmdSize ? CommandMemorySize
+                                                                                          : minCmdSize) ||
+          !allocateControlBlock(frame.cmdMemory, ControlMemorySize > (size_t) minCtrlSize ? ControlMemorySize
+                                                                                          : minCtrlSize)) {
+        return false;
+      }
+    }
+
+    Logger::log("Finished.\n");
+
+    return true;
+  }
+
+  // hands the frame's command memory to the command buffer, records the begin timestamp and the texture uploads, then
+  // starts recording the frame's draws. blocks added by the memory callback during the frame's last recording are
+  // merged into a single block, big enough for all of them
+  bool beginFrameCommands(FrameResources &frame) {
+
+    auto bd = getBackendData();
+    CommandMemory &memory = frame.cmdMemory;
+
+    if (memory.commandBlocks.Size > 1) {
+      size_t size = memory.commandSize;
+      for (auto &block: memory.commandBlocks) {
+        MemoryArena::Free(block);
+      }
+      memory.commandBlocks.resize(0);
+      memory.commandSize = 0;
+
+      Logger::log("Growing Command Memory to Size: %x\n", size);
+      if (!allocateCommandBlock(memory, size)) {
+        return false;
+      }
+    }
+
+    if (memory.controlBlocks.Size > 1) {
+      size_t size = memory.controlSize;
+      for (auto &block: memory.controlBlocks) {
+        Mem::Deallocate(block.ptr);
+      }
+      memory.controlBlocks.resize(0);
+      memory.controlSize = 0;
+
+      Logger::log("Growing Control Memory to Size: %x\n", size);
+      if (!allocateControlBlock(memory, size)) {
+        return false;
+      }
+    }
+
+    if (memory.commandBlocks.empty() || memory.controlBlocks.empty()) {
+      return false;
+    }
+
+    auto &cmdBlock = memory.commandBlocks[0];
+    auto &ctrlBlock = memory.controlBlocks[0];
+
+    bd->cmdBuf->SetMemoryCallbackData(&memory);
+    bd->cmdBuf->AddCommandMemory(cmdBlock.pool, cmdBlock.offset, cmdBlock.size);
+    bd->cmdBuf->AddControlMemory(ctrlBlock.ptr, ctrlBlock.size);
+
+    bd->cmdBuf->BeginRecording();
+
+    bd->recordingFrame = &frame;
+    bd->cmdBuf->ReportCounter(nvn::CounterType::TIMESTAMP, *frame.timestampBuffer);
+    recordTextureUploads(frame);
+    frame.beginHandle = bd->cmdBuf->EndRecording();
+
+    bd->cmdBuf->BeginRecording();
+
+    return true;
+  }
+
+  // ends the recording of the frame's draws, and submits them between the commands recorded by beginFrameCommands and
+  // the end timestamp. returns the handle of the draws alone, which can be submitted again without the rest
+  nvn::CommandHandle submitFrameCommands() {
+
+    auto bd = getBackendData();
+
+    FrameResources &frame = *bd->recordingFrame;
+
+    // texture/sampler pools stay bound on the queue after our commands, so give the game its own back
+    if (bd->gameTexPool) {
+      bd->cmdBuf->SetTexturePool(bd->gameTexPool);
+    }
+    if (bd->gameSamplerPool) {
+      bd->cmdBuf->SetSamplerPool(bd->gameSamplerPool);
+    }
+
+    nvn::CommandHandle handles[3];
+    handles[0] = frame.beginHandle;
+    handles[1] = bd->cmdBuf->EndRecording();
+
+    bd->cmdBuf->BeginRecording();
+    bd->cmdBuf->ReportCounter(nvn::CounterType::TIMESTAMP, *frame.timestampBuffer + sizeof(nvn::CounterData));
+    handles[2] = bd->cmdBuf->EndRecording();
+    frame.hasTimestamps = true;
+
+    bd->queue->SubmitCommands(3, handles);
+
+    return handles[1];
+  }
+
+  void setGamePools(const nvn::TexturePool *texPool, const nvn::SamplerPool *samplerPool) {
+    auto bd = getBackendData();
+    bd->gameTexPool = texPool;
+    bd->gameSamplerPool = samplerPool;
+  }
+
+  // best-fit search through the retired buffers, returns nullptr if none of them are big enough
+  MemoryBuffer *takeRetiredBuffer(size_t size) {
+
+    auto bd = getBackendData();
+
+    int bestIdx = -1;
+    for (int i = 0; i < bd->retiredBuffers.Size; i++) {
+      size_t poolSize = bd->retiredBuffers[i]->GetPoolSize();
+      if (poolSize >= size && (bestIdx == -1 || poolSize < bd->retiredBuffers[bestIdx]->GetPoolSize())) {
+        bestIdx = i;
+      }
+    }
+
+    if (bestIdx == -1) {
+      return nullptr;
+    }
+
+    MemoryBuffer *result = bd->retiredBuffers[bestIdx];
+    bd->retiredBuffers.erase_unsorted(bd->retiredBuffers.Data + bestIdx);
+    return result;
+  }
+
+  void retireBuffer(MemoryBuffer *buffer) {
+
+    auto bd = getBackendData();
+
+    bd->retiredBuffers.push_back(buffer);
+
+    if (bd->retiredBuffers.Size <= MaxRetiredBuffers) {
+      return;
+    }
+
+    // too many buffers kept around, free the smallest as it's the least likely to be reused
+    int smallestIdx = 0;
+    for (int i = 1; i < bd->retiredBuffers.Size; i++) {
+      if (bd->retiredBuffers[i]->GetPoolSize() < bd->retiredBuffers[smallestIdx]->GetPoolSize()) {
+        smallestIdx = i;
+      }
+    }
+
+    MemoryBuffer *smallest = bd->retiredBuffers[smallestIdx];
+    bd->retiredBuffers.erase_unsorted(bd->retiredBuffers.Data + smallestIdx);
+
+    smallest->Finalize();
+    IM_FREE(smallest);
+  }
+
+  bool growStreamBuffer(StreamBuffer &stream, size_t requiredSize, StreamBufferStats &stats, const char *name) {
+
+    if (requiredSize > stats.highWaterMark) {
+      stats.highWaterMark = requiredSize;
+    }
+
+    // keep track of what the previous exact-fit policy would have done, to see how many reallocations we saved
+    size_t exactFitSize = ALIGN_UP(requiredSize, 0x1000);
+    bool isExactFitRealloc = exactFitSize > stream.exactFitSize;
+    if (isExactFitRealloc) {
+      stream.exactFitSize = exactFitSize;
+    }
+
+    if (stream.memory && stream.memory->GetPoolSize() >= requiredSize) {
+      if (isExactFitRealloc) {
+        stats.avoidedReallocs++;
+      }
+      return stream.memory->IsBufferReady();
+    }
+
+    // grow geometrically, and straight to the biggest size any frame has needed so far
+    size_t capacity = stream.memory ? (size_t) (stream.memory->GetPoolSize() * BufferGrowthFactor) : 0;
+    if (capacity < stats.highWaterMark) {
+      capacity = stats.highWaterMark;
+    }
+
+    MemoryBuffer *buffer = takeRetiredBuffer(requiredSize);
+
+    if (stream.memory) {
+      retireBuffer(stream.memory);
+    }
+
+    if (buffer) {
+      stats.reuses++;
+      Logger::log("Reusing Retired Buffer for %s Buffer, Size: %d\n", name, buffer->GetPoolSize());
+    } else {
+      buffer = IM_NEW(MemoryBuffer)(capacity);
+      stats.allocations++;
+      Logger::log("Resizing %s Buffer to Size: %d (allocations: %d, reuses: %d, avoided reallocations: %d)\n",
+                  name, capacity, stats.allocations, stats.reuses, stats.avoidedReallocs);
+    }
+
+    stream.memory = buffer;
+
+    return buffer->IsBufferReady();
+  }
+
+  // streaming buffers live in write-combined memory (see IMGUI_XENO_NON_TEMPORAL_UPLOAD)
+  inline void uploadToStream(u8 *dst, const void *src, size_t size) {
+#if IMGUI_XENO_NON_TEMPORAL_UPLOAD
+    Mem::CopyNonTemporal(dst, src, size);
+#else
+    memcpy(dst, src, size);
+#endif
+  }
+
+  // copies a list's indices into the stream, offset so they address the frame's vertex buffer directly. they get
+  // rebased into a small cached chunk first, so the stream only sees uploadToStream's bulk copies
+  void uploadRebasedIndices(ImDrawIdx *dst, const ImDrawIdx *src, int count, int baseVertex) {
+    constexpr int ChunkSize = 1024;
+    ImDrawIdx chunk[ChunkSize];
+
+    for (int start = 0; start < count; start += ChunkSize) {
+      int chunkCount = count - start < ChunkSize ? count - start : ChunkSize;
+      for (int i = 0; i < chunkCount; i++) {
+        chunk[i] = (ImDrawIdx) (src[start + i] + baseVertex);
+      }
+      uploadToStream((u8 *) (dst + start), chunk, chunkCount * sizeof(ImDrawIdx));
+    }
+  }
+
+  bool setupShaders(u8 *shaderBinary, ulong binarySize) {
+
+    Logger::log("Setting up ImGui Shaders.\n");
+
+    auto bd = getBackendData();
+
+    if (!bd->shaderProgram.Initialize(bd->device)) {
+      Logger::log("Failed to Initialize Shader Program!");
+      return false;
+    }
+
+    bd->shaderMemory = IM_NEW(MemoryBuffer)(binarySize, shaderBinary, nvn::MemoryPoolFlags::CPU_UNCACHED |
+                                                                      nvn::MemoryPoolFlags::GPU_CACHED |
+                                                                      nvn::MemoryPoolFlags::SHADER_CODE);
+
+    if (!bd->shaderMemory->IsBufferReady()) {
+      Logger::log("Shader Memory Pool not Ready! Unable to continue.\n");
+      return false;
+    }
+
+    BinaryHeader offsetData = BinaryHeader((u32 *) shaderBinary);
+
+    nvn::BufferAddress addr = bd->shaderMemory->GetBufferAddress();
+
+    nvn::ShaderData &vertShaderData = bd->shaderDatas[0];
+    vertShaderData.data = addr + offsetData.mVertexDataOffset;
+    vertShaderData.control = shaderBinary + offsetData.mVertexControlOffset;
+
+    nvn::ShaderData &fragShaderData = bd->shaderDatas[1];
+    fragShaderData.data = addr + offsetData.mFragmentDataOffset;
+    fragShaderData.control = shaderBinary + offsetData.mFragmentControlOffset;
+
+    if (!bd->shaderProgram.SetShaders(2, bd->shaderDatas)) {
+      Logger::log("Failed to Set shader data for program.\n");
+      return false;
+    }
+
+    bd->shaderProgram.SetDebugLabel("ImGuiShader");
+
+    // Uniform Block Object Memory Setup
+
+    bd->uniformMemory = IM_NEW(MemoryBuffer)(UBOSIZE);
+
+    if (!bd->uniformMemory->IsBufferReady()) {
+      Logger::log("Uniform Memory Pool not Ready! Unable to continue.\n");
+      return false;
+    }
+
+    // setup vertex attrib & stream
+
+    bd->attribStates[0].SetDefaults().SetFormat(nvn::Format::RG32F, offsetof(ImDrawVert, pos)); // pos
+    bd->attribStates[1].SetDefaults().SetFormat(nvn::Format::RG32F, offsetof(ImDrawVert, uv)); // uv
+    bd->attribStates[2].SetDefaults().SetFormat(nvn::Format::RGBA8, offsetof(ImDrawVert, col)); // color
+
+    bd->streamState.SetDefaults().SetStride(sizeof(ImDrawVert));
+
+    setupRenderStates();
+
+    Logger::log("Finished.\n");
+
+    return true;
+  }
+
+  void InitBackend(const NvnBackendInitInfo &initInfo) {
+    ImGuiIO &io = ImGui::GetIO();
+    XENO_ASSERT(!io.BackendRendererUserData, "Already Initialized Imgui Backend!");
+
+    io.BackendPlatformName = "Switch";
+    io.BackendRendererName = "imgui_impl_nvn";
+    io.IniFilename = nullptr;
+    io.MouseDrawCursor = true;
+    io.ConfigFlags |= ImGuiConfigFlags_IsTouchScreen;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
+    io.BackendFlags |= ImGuiBackendFlags_HasGamepad;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+
+    io.DisplaySize = ImVec2(IMGUI_XENO_VIEWPORT_WIDTH, IMGUI_XENO_VIEWPORT_HEIGHT); // default size
+
+    // calculate ortho matrix
+    orthoRH_ZO(projMatrix, 0.0f, io.DisplaySize.x, io.DisplaySize.y, 0.0f, -1.0f, 1.0f);
+
+    auto *bd = IM_NEW(NvnBackendData)();
+    io.BackendRendererUserData = (void *) bd;
+    nn::os::InitializeMutex(&bd->arenaMutex, true, 0);
+
+    bd->device = initInfo.device;
+    bd->queue = initInfo.queue;
+    bd->isInitialized = false;
+
+#if IMGUI_XENO_LOAD_DEFAULT_FONT
+    io.Fonts->AddFontFromMemoryCompressedTTF(
+        JetBrainsMonoNL_compressed_data, JetBrainsMonoNL_compressed_size,
+        18.f
+    );
+#endif
+
+    if (createShaders()) {
+      Logger::log("Shader Binaries Loaded! Setting up Render Data.\n");
+
+      if (bd->isUseTestShader)
+        initTestShader();
+
+      if (setupShaders(bd->imguiShaderBinary.ptr, bd->imguiShaderBinary.size) && setupFont() &&
+          setupFrameResources() && setupCommandBuffer()) {
+        Logger::log("Rendering Setup!\n");
+
+        MemoryArena::LogStats();
+
+        bd->isInitialized = true;
+
+      } else {
+        Logger::log("Failed to Setup Render Data!\n");
+      }
+    }
+  }
+
+  void ShutdownBackend() {
+
+  }
+
+  bool updateTouch(ImGuiIO &io) {
+    ImVec2 pos(0, 0);
+    if (!InputHelper::getTouchCoords(&pos.x, &pos.y)) {
+      if (InputHelper::isTouchRelease()) {
+        io.AddMouseButtonEvent(ImGuiMouseButton_Left, false);
+      }
+      return false;
+    }
+
+    io.AddMouseSourceEvent(ImGuiMouseSource_TouchScreen);
+
+    pos.x = (pos.x / (float) IMGUI_XENO_VIEWPORT_WIDTH) * io.DisplaySize.x;
+    pos.y = (pos.y / (float) IMGUI_XENO_VIEWPORT_HEIGHT) * io.DisplaySize.y;
+    io.AddMousePosEvent(pos.x, pos.y);
+
+    if (InputHelper::isTouchPress()) {
+      io.AddMouseButtonEvent(ImGuiMouseButton_Left, true);
+    }
+    return true;
+  }
+
+  void updateMouse(ImGuiIO &io) {
+    ImVec2 mousePos(0, 0);
+    InputHelper::getMouseCoords(&mousePos.x, &mousePos.y);
+
+    io.AddMouseSourceEvent(ImGuiMouseSource_Mouse);
+
+    // Workaround from https://github.com/Amethyst-szs/smo-lunakit
+    mousePos = ImVec2((mousePos.x / (float) IMGUI_XENO_VIEWPORT_WIDTH) * io.DisplaySize.x,
+                      (mousePos.y / (float) IMGUI_XENO_VIEWPORT_HEIGHT) * io.DisplaySize.y);
+    io.AddMousePosEvent(mousePos.x, mousePos.y);
+
+    ImVec2 scrollDelta(0, 0);
+    InputHelper::getScrollDelta(&scrollDelta.x, &scrollDelta.y);
+
+    if (scrollDelta.x != 0.0f)
+      io.AddMouseWheelEvent(0.0f, scrollDelta.x > 0.0f ? 0.5f : -0.5f);
+
+    for (auto [im_k, nx_k]: mouse_mapping) {
+      if (InputHelper::isMousePress((nn::hid::MouseButton) nx_k))
+        io.AddMouseButtonEvent((ImGuiMouseButton) im_k, true);
+      else if (InputHelper::isMouseRelease((nn::hid::MouseButton) nx_k))
+        io.AddMouseButtonEvent((ImGuiMouseButton) im_k, false);
+    }
+  }
+
+  void updateKeyboard(ImGuiIO &io) {
+    for (auto [im_k, nx_k]: key_mapping) {
+      if (InputHelper::isKeyPress((nn::hid::KeyboardKey) nx_k)) {
+        io.AddKeyEvent((ImGuiKey) im_k, true);
+      } else if (InputHelper::isKeyRelease((nn::hid::KeyboardKey) nx_k)) {
+        io.AddKeyEvent((ImGuiKey) im_k, false);
+      }
+    }
+  }
+
+  void updateGamepad(ImGuiIO &io) {
     for (auto [im_k, nx_k]: npad_mapping) {
       if (InputHelper::isButtonPress((nn::hid::NpadButton) nx_k))
         io.AddKeyEvent((ImGuiKey) im_k, true);
@@ -542,88 +1650,798 @@ namespace ImguiNvnBackend {
         io.AddKeyEvent((ImGuiKey) im_k, false);
     }
 
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickLeft, InputHelper::getLeftStickLeft() > 0.8f, InputHelper::getLeftStickLeft());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickRight, InputHelper::getLeftStickRight() > 0.8f, InputHelper::getLeftStickRight());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickUp, InputHelper::getLeftStickUp() > 0.8f, InputHelper::getLeftStickUp());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickDown, InputHelper::getLeftStickDown() > 0.8f, InputHelper::getLeftStickDown());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickLeft, InputHelper::getLeftStickLeft() > 0.8f, InputHelper::getLeftStickLeft());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickRight, InputHelper::getLeftStickRight() > 0.8f, InputHelper::getLeftStickRight());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickUp, InputHelper::getLeftStickUp() > 0.8f, InputHelper::getLeftStickUp());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadLStickDown, InputHelper::getLeftStickDown() > 0.8f, InputHelper::getLeftStickDown());
+
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickLeft, InputHelper::getRightStickLeft() > 0.8f, InputHelper::getRightStickLeft());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickRight, InputHelper::getRightStickRight() > 0.8f, InputHelper::getRightStickRight());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickUp, InputHelper::getRightStickUp() > 0.8f, InputHelper::getRightStickUp());
+    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickDown, InputHelper::getRightStickDown() > 0.8f, InputHelper::getRightStickDown());
+  }
+
+  void updateInput() {
+
+    ImGuiIO &io = ImGui::GetIO();
+
+#if IMGUI_XENO_INPUT_TOUCH
+    if (updateTouch(io)) {
+      // Handled touch screen input, disable other inputs for this frame.
+      return;
+    }
+#endif
+
+#if IMGUI_XENO_INPUT_KBM
+    updateKeyboard(io);
+    updateMouse(io);
+#endif
+
+#if IMGUI_XENO_INPUT_PAD
+    if (InputHelper::isInputToggled()) {
+      updateGamepad(io);
+    }
+#endif
+
+  }
+
+  void newFrame() {
+    ImGuiIO &io = ImGui::GetIO();
+    auto *bd = getBackendData();
+
+    nn::TimeSpan curTick = nn::os::GetSystemTick().ToTimeSpan();
+    nn::TimeSpan prevTick(bd->lastTick);
+    io.DeltaTime = fabsf((float) (curTick - prevTick).GetNanoSeconds() / 1e9f);
+
+    bd->lastTick = curTick;
+
+    // input might have already been polled for this frame, while deciding whether to update
+    if (!bd->isInputPolled) {
+      pollInput();
+    }
+    bd->isInputPolled = false;
+  }
+
+  void pollInput() {
+    auto *bd = getBackendData();
+
+    InputHelper::updatePadState(); // update input helper
+
+#if IMGUI_XENO_CAPTURE_HOTKEY
+    if (InputHelper::isHoldZL() && InputHelper::isHoldZR() && InputHelper::isPressMinus()) {
+      requestCapture(nullptr);
+    }
+#endif
+
+    updateInput(); // update backend inputs
+
+    bd->isInputPolled = true;
+  }
+
+  void setupRenderStates() {
+
+    auto bd = getBackendData();
+
+    bd->polyState.SetDefaults();
+    bd->polyState.SetPolygonMode(nvn::PolygonMode::FILL);
+    bd->polyState.SetCullFace(nvn::Face::NONE);
+    bd->polyState.SetFrontFace(nvn::FrontFace::CCW);
+
+    bd->colorState.SetDefaults();
+    bd->colorState.SetLogicOp(nvn::LogicOp::COPY);
+    bd->colorState.SetAlphaTest(nvn::AlphaFunc::ALWAYS);
+    for (int i = 0; i < 8; ++i) {
+      bd->colorState.SetBlendEnable(i, true);
+    }
+
+    bd->blendState.SetDefaults();
+    bd->blendState.SetBlendFunc(nvn::BlendFunc::SRC_ALPHA, nvn::BlendFunc::ONE_MINUS_SRC_ALPHA, nvn::BlendFunc::ONE,
+                                nvn::BlendFunc::ZERO);
+    bd->blendState.SetBlendEquation(nvn::BlendEquation::ADD, nvn::BlendEquation::ADD);
+
+    // the overlay cache accumulates premultiplied colors, which are then blended onto the screen as-is
+    bd->cacheBlendState.SetDefaults();
+    bd->cacheBlendState.SetBlendFunc(nvn::BlendFunc::SRC_ALPHA, nvn::BlendFunc::ONE_MINUS_SRC_ALPHA,
+                                     nvn::BlendFunc::ONE, nvn::BlendFunc::ONE_MINUS_SRC_ALPHA);
+    bd->cacheBlendState.SetBlendEquation(nvn::BlendEquation::ADD, nvn::BlendEquation::ADD);
+
+    bd->compositeBlendState.SetDefaults();
+    bd->compositeBlendState.SetBlendFunc(nvn::BlendFunc::ONE, nvn::BlendFunc::ONE_MINUS_SRC_ALPHA,
+                                         nvn::BlendFunc::ONE, nvn::BlendFunc::ZERO);
+    bd->compositeBlendState.SetBlendEquation(nvn::BlendEquation::ADD, nvn::BlendEquation::ADD);
+  }
+
+  void resetStateCache() {
+
+    auto bd = getBackendData();
+
+    bd->stateCache = RenderStateCache{};
+  }
+
+  void setViewport(int x, int y, int w, int h) {
+
+    auto bd = getBackendData();
+    int *viewport = bd->stateCache.viewport;
+
+    if (viewport[0] == x && viewport[1] == y && viewport[2] == w && viewport[3] == h) {
+      bd->stateCache.skippedBinds++;
+      return;
+    }
+
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = w;
+    viewport[3] = h;
+    bd->cmdBuf->SetViewport(x, y, w, h);
+  }
+
+  void setScissor(int x, int y, int w, int h) {
+
+    auto bd = getBackendData();
+    int *scissor = bd->stateCache.scissor;
+
+    if (scissor[0] == x && scissor[1] == y && scissor[2] == w && scissor[3] == h) {
+      bd->stateCache.skippedBinds++;
+      return;
+    }
+
+    scissor[0] = x;
+    scissor[1] = y;
+    scissor[2] = w;
+    scissor[3] = h;
+    bd->cmdBuf->SetScissor(x, y, w, h);
+  }
+
+  void bindTexture(nvn::TextureHandle texture) {
+
+    auto bd = getBackendData();
+
+    if (bd->stateCache.texture == texture) {
+      bd->stateCache.skippedBinds++;
+      return;
+    }
+
+    bd->stateCache.texture = texture;
+    bd->cmdBuf->BindTexture(nvn::ShaderStage::FRAGMENT, 0, texture);
+  }
+
+  void bindVertexBuffer(nvn::BufferAddress address, size_t size) {
+
+    auto bd = getBackendData();
+
+    if (bd->stateCache.vtxBufferAddress == address && bd->stateCache.vtxBufferSize == size) {
+      bd->stateCache.skippedBinds++;
+      return;
+    }
+
+    bd->stateCache.vtxBufferAddress = address;
+    bd->stateCache.vtxBufferSize = size;
+    bd->cmdBuf->BindVertexBuffer(0, address, size);
+  }
+
+  void bindBlendState(const nvn::BlendState *blendState) {
+
+    auto bd = getBackendData();
+
+    if (bd->stateCache.blendState == blendState) {
+      bd->stateCache.skippedBinds++;
+      return;
+    }
+
+    bd->stateCache.blendState = blendState;
+    bd->cmdBuf->BindBlendState(blendState);
+  }
+
+  void setRenderStates() {
+
+    auto bd = getBackendData();
+
+    // state objects are prebaked in setupRenderStates, so this only records the binds
+    bd->cmdBuf->BindPolygonState(&bd->polyState);
+    bd->cmdBuf->BindColorState(&bd->colorState);
+    bindBlendState(&bd->blendState);
+
+    bd->cmdBuf->BindVertexAttribState(3, bd->attribStates);
+    bd->cmdBuf->BindVertexStreamState(1, &bd->streamState);
+
+    bd->cmdBuf->SetTexturePool(&bd->texPool);
+    bd->cmdBuf->SetSamplerPool(&bd->samplerPool);
+  }
+
+  // appends a draw command to the current frame's batches, merging it into the previous batch if it uses the same
+  // scissor, texture and base vertex, and its indices directly follow the previous batch's
+#if IMGUI_XENO_INDIRECT_DRAWS
+  // whether every vertex the command draws lies inside of the scissor. triangles then only cover pixels whose centers
+  // are inside of it, which the scissor wouldn't clip
+  bool isCmdInsideScissor(const ImDrawList *cmdList, const ImDrawCmd &cmd, const int scissor[4]) {
+
+    float x1 = (float) scissor[0], y1 = (float) scissor[1];
+    float x2 = (float) (scissor[0] + scissor[2]), y2 = (float) (scissor[1] + scissor[3]);
+
+    const ImDrawIdx *indices = cmdList->IdxBuffer.Data + cmd.IdxOffset;
+    const ImDrawVert *vertices = cmdList->VtxBuffer.Data + cmd.VtxOffset;
+    for (unsigned int i = 0; i < cmd.ElemCount; i++) {
+      const ImVec2 &pos = vertices[indices[i]].pos;
+      if (pos.x < x1 || pos.y < y1 || pos.x > x2 || pos.y > y2) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+#endif
+
+  void addDrawBatch(const ImDrawList *cmdList, const ImDrawCmd &cmd, int baseVertex, int globalIdxOffset) {
+
+    auto bd = getBackendData();
+
+    ImVec2 clip_min(cmd.ClipRect.x, cmd.ClipRect.y);
+    ImVec2 clip_max(cmd.ClipRect.z, cmd.ClipRect.w);
+    ImVec2 clip_size(clip_max.x - clip_min.x, clip_max.y - clip_min.y);
+
+    if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+      return;
+
+    DrawBatch batch = {
+        .scissor = {(int) clip_min.x, (int) clip_min.y, (int) clip_size.x, (int) clip_size.y},
+        .texture = *(nvn::TextureHandle *) cmd.GetTexID(),
+        .vtxOffset = (int) cmd.VtxOffset + baseVertex,
+        .idxOffset = (int) cmd.IdxOffset + globalIdxOffset,
+        .elemCount = (int) cmd.ElemCount,
+        .isInsideScissor = false
+    };
+
+#if IMGUI_XENO_INDIRECT_DRAWS
+    batch.isInsideScissor = isCmdInsideScissor(cmdList, cmd, batch.scissor);
+#else
+    (void) cmdList;
+#endif
+
+    if (!bd->drawBatches.empty()) {
+      DrawBatch &prev = bd->drawBatches.back();
+
+      if (prev.texture == batch.texture && prev.vtxOffset == batch.vtxOffset &&
+          prev.idxOffset + prev.elemCount == batch.idxOffset &&
+          memcmp(prev.scissor, batch.scissor, sizeof(batch.scissor)) == 0) {
+        prev.elemCount += batch.elemCount;
+        prev.isInsideScissor = prev.isInsideScissor && batch.isInsideScissor;
+        return;
+      }
+    }
+
+    markUserTextureUse((const nvn::TextureHandle *) cmd.GetTexID());
+    bd->drawBatches.push_back(batch);
+  }
+
+  static constexpr u64 HashSeed = 0xCBF29CE484222325;
+
+  // cheap 64-bit hash (FNV-1a over 8 byte words), only used to detect frames that didn't change
+  u64 hashData(const void *data, size_t size, u64 hash) {
+
+    auto words = (const u64 *) data;
+    size_t wordCount = size / sizeof(u64);
+    for (size_t i = 0; i < wordCount; i++) {
+      hash = (hash ^ words[i]) * 0x100000001B3;
+    }
+
+    auto bytes = (const u8 *) (words + wordCount);
+    for (size_t i = 0; i < size % sizeof(u64); i++) {
+      hash = (hash ^ bytes[i]) * 0x100000001B3;
+    }
 
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickLeft, InputHelper::getRightStickLeft() > 0.8f, InputHelper::getRightStickLeft());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickRight, InputHelper::getRightStickRight() > 0.8f, InputHelper::getRightStickRight());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickUp, InputHelper::getRightStickUp() > 0.8f, InputHelper::getRightStickUp());
-    io.AddKeyAnalogEvent(ImGuiKey_GamepadRStickDown, InputHelper::getRightStickDown() > 0.8f, InputHelper::getRightStickDown());
+    return hash;
   }
 
-  void updateInput() {
+  // hashes a draw list's geometry and draw commands
+  u64 hashDrawList(ImDrawList *cmdList, u64 hash) {
 
-    ImGuiIO &io = ImGui::GetIO();
+    hash = hashData(cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size * sizeof(ImDrawVert), hash);
+    hash = hashData(cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx), hash);
 
-#if IMGUI_XENO_INPUT_TOUCH
-    if (updateTouch(io)) {
-      // Handled touch screen input, disable other inputs for this frame.
-      return;
+    for (auto &cmd: cmdList->CmdBuffer) {
+      nvn::TextureHandle texture = *(nvn::TextureHandle *) cmd.GetTexID();
+
+      hash = hashData(&cmd.ClipRect, sizeof(cmd.ClipRect), hash);
+      hash = hashData(&texture, sizeof(texture), hash);
+      hash = hashData(&cmd.VtxOffset, sizeof(cmd.VtxOffset), hash);
+      hash = hashData(&cmd.IdxOffset, sizeof(cmd.IdxOffset), hash);
+      hash = hashData(&cmd.ElemCount, sizeof(cmd.ElemCount), hash);
     }
-#endif
 
-#if IMGUI_XENO_INPUT_KBM
-    updateKeyboard(io);
-    updateMouse(io);
+    return hash;
+  }
+
+  // hashes everything that ends up in the recorded command stream: display size, geometry and draw commands, and the
+  // texture the overlay cache gets composited onto
+  u64 hashDrawData(ImDrawData *drawData) {
+
+    u64 hash = HashSeed;
+    hash = hashData(&drawData->DisplaySize, sizeof(drawData->DisplaySize), hash);
+
+#if IMGUI_XENO_OVERLAY_CACHE
+    // the game presents a different texture of its window every frame, and the recording binds the one it had
+    auto bd = getBackendData();
+    hash = hashData(&bd->presentTarget, sizeof(bd->presentTarget), hash);
 #endif
 
-#if IMGUI_XENO_INPUT_PAD
-    if (InputHelper::isInputToggled()) {
-      updateGamepad(io);
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+      hash = hashDrawList(drawData->CmdLists[i], hash);
     }
-#endif
 
+    return hash;
   }
 
-  void newFrame() {
-    ImGuiIO &io = ImGui::GetIO();
-    auto *bd = getBackendData();
+  // resubmits the draws of the last recorded frame. its geometry stays valid, since the ring isn't advanced while
+  // replaying, and its slot gets fenced again so it won't be overwritten before the GPU is done with the replay.
+  // texture uploads are left for the next recorded frame (staging them invalidates the recording anyway), and no
+  // timestamps are written, so the GPU time stays the one of the last recorded frame
+  void replayRecordedFrame(ImDrawData *drawData) {
 
-    nn::TimeSpan curTick = nn::os::GetSystemTick().ToTimeSpan();
-    nn::TimeSpan prevTick(bd->lastTick);
-    io.DeltaTime = fabsf((float) (curTick - prevTick).GetNanoSeconds() / 1e9f);
+    auto bd = getBackendData();
 
-    bd->lastTick = curTick;
+    bd->queue->SubmitCommands(1, &bd->recordedFrame.handle);
+    bd->queue->FenceSync(&bd->frames[bd->recordedFrame.frameIndex].fence,
+                         nvn::SyncCondition::ALL_GPU_COMMANDS_COMPLETE, nvn::SyncFlagBits::FLUSH_FOR_CPU);
 
-    InputHelper::updatePadState(); // update input helper
+    bd->recordedFrame.replayCount++;
 
-    updateInput(); // update backend inputs
+    // nothing got recorded this frame, the draws of the recording shouldn't show up as this frame's
+    bd->drawStats.cmdsIn = 0;
+    bd->drawStats.drawsOut = 0;
+    bd->drawStats.drawCalls = 0;
+    bd->drawStats.skippedBinds = 0;
+    bd->drawStats.vtxCount = drawData->TotalVtxCount;
+    bd->drawStats.idxCount = drawData->TotalIdxCount;
+    bd->drawStats.isReplayed = true;
   }
 
-  void setRenderStates() {
+  void invalidateRecordedFrame() {
+    auto bd = getBackendData();
+    nn::os::LockMutex(&bd->textureMutex);
+    bd->isRecordedFrameStale = true;
+    nn::os::UnlockMutex(&bd->textureMutex);
+  }
+
+  // only the render thread touches the recorded frame and the overlay cache. an invalidation landing while it records
+  // a frame stays pending until the next one, instead of getting overwritten once the recording is done
+  void applyInvalidations() {
 
     auto bd = getBackendData();
 
-    nvn::PolygonState polyState;
-    polyState.SetDefaults();
-    polyState.SetPolygonMode(nvn::PolygonMode::FILL);
-    polyState.SetCullFace(nvn::Face::NONE);
-    polyState.SetFrontFace(nvn::FrontFace::CCW);
-    bd->cmdBuf->BindPolygonState(&polyState);
+    nn::os::LockMutex(&bd->textureMutex);
 
-    nvn::ColorState colorState;
-    colorState.SetDefaults();
-    colorState.SetLogicOp(nvn::LogicOp::COPY);
-    colorState.SetAlphaTest(nvn::AlphaFunc::ALWAYS);
-    for (int i = 0; i < 8; ++i) {
-      colorState.SetBlendEnable(i, true);
+    if (bd->isRecordedFrameStale) {
+      bd->recordedFrame.isValid = false;
+      bd->isRecordedFrameStale = false;
+    }
+    if (bd->isOverlayCacheStale) {
+      bd->overlayCache.isValid = false;
+      bd->isOverlayCacheStale = false;
     }
-    bd->cmdBuf->BindColorState(&colorState);
 
-    nvn::BlendState blendState;
-    blendState.SetDefaults();
-    blendState.SetBlendFunc(nvn::BlendFunc::SRC_ALPHA, nvn::BlendFunc::ONE_MINUS_SRC_ALPHA, nvn::BlendFunc::ONE,
-                            nvn::BlendFunc::ZERO);
-    blendState.SetBlendEquation(nvn::BlendEquation::ADD, nvn::BlendEquation::ADD);
-    bd->cmdBuf->BindBlendState(&blendState);
+    nn::os::UnlockMutex(&bd->textureMutex);
+  }
 
-    bd->cmdBuf->BindVertexAttribState(3, bd->attribStates);
-    bd->cmdBuf->BindVertexStreamState(1, &bd->streamState);
+  void requestCapture(const char *path) {
 
-    bd->cmdBuf->SetTexturePool(&bd->texPool);
-    bd->cmdBuf->SetSamplerPool(&bd->samplerPool);
+    auto bd = getBackendData();
+
+    if (path) {
+      nn::util::SNPrintf(bd->capturePath, sizeof(bd->capturePath), "%s", path);
+    } else {
+      // named after the tick, so captures from previous boots aren't overwritten
+      nn::util::SNPrintf(bd->capturePath, sizeof(bd->capturePath), "%s/capture_%lld.xcap", IMGUI_XENO_CAPTURE_PATH,
+                         (long long) nn::os::GetSystemTick().GetInt64Value());
+    }
+
+    bd->isCaptureRequested = true;
+  }
+
+  // serializes the draw data and writes it out on the render thread, so the frame it happens on is slow
+  void writeCapture(ImDrawData *drawData) {
+
+    auto bd = getBackendData();
+    bd->isCaptureRequested = false;
+
+    ImVector<u8> data;
+    if (!DrawDataCapture::write(drawData, data)) {
+      Logger::log("Failed to Capture Frame!\n");
+      return;
+    }
+
+    if (strncmp(bd->capturePath, IMGUI_XENO_CAPTURE_PATH "/", strlen(IMGUI_XENO_CAPTURE_PATH "/")) == 0) {
+      FsHelper::createDirectory(IMGUI_XENO_CAPTURE_PATH);
+    }
+
+    if (FsHelper::writeFileToPath(data.Data, data.Size, bd->capturePath)) {
+      Logger::log("Failed to Write Frame Capture!\n");
+      return;
+    }
+
+    Logger::log("Captured Frame: %d Lists, %d Vertices, %d Indices (%d bytes)\n", drawData->CmdListsCount,
+                drawData->TotalVtxCount, drawData->TotalIdxCount, data.Size);
+  }
+
+  // blocks until the GPU is done with every frame in the ring
+  void waitForFrames() {
+
+    auto bd = getBackendData();
+
+    for (auto &frame: bd->frames) {
+      if (frame.isFenceSubmitted) {
+        frame.fence.Wait(UINT64_MAX);
+        frame.isFenceSubmitted = false;
+      }
+    }
+    bd->completedFrames = bd->submittedFrames;
+
+    nn::os::LockMutex(&bd->textureMutex);
+    bd->stagingRing.releasePos = bd->stagingRing.flushedPos;
+    nn::os::UnlockMutex(&bd->textureMutex);
+  }
+
+  void setPresentTarget(nvn::Texture *texture) {
+    auto bd = getBackendData();
+    bd->presentTarget = texture;
+  }
+
+  bool setupOverlayCache(int width, int height) {
+
+    auto bd = getBackendData();
+    OverlayCache &cache = bd->overlayCache;
+
+    if (cache.isTextureReady) {
+      // the old texture might still be sampled by frames in flight
+      waitForFrames();
+      cache.texture.Finalize();
+      MemoryArena::Free(cache.memory);
+      cache.isTextureReady = false;
+    }
+
+    Logger::log("Setting up Overlay Cache. Size: %dx%d\n", width, height);
+
+    bd->texBuilder.SetDefaults()
+        .SetDevice(bd->device)
+        .SetFlags(nvn::TextureFlags::COMPRESSIBLE)
+        .SetTarget(nvn::TextureTarget::TARGET_2D)
+        .SetFormat(nvn::Format::RGBA8)
+        .SetSize2D(width, height);
+
+    if (!MemoryArena::Allocate(&cache.memory, bd->texBuilder.GetStorageSize(),
+                               nvn::MemoryPoolFlags::CPU_NO_ACCESS | nvn::MemoryPoolFlags::GPU_CACHED |
+                               nvn::MemoryPoolFlags::COMPRESSIBLE,
+                               bd->texBuilder.GetStorageAlignment())) {
+      Logger::log("Failed to Create Overlay Cache Memory Pool!\n");
+      return false;
+    }
+
+    bd->texBuilder.SetStorage(cache.memory.pool, cache.memory.offset);
+
+    if (!cache.texture.Initialize(&bd->texBuilder)) {
+      Logger::log("Failed to Create Overlay Cache Texture!\n");
+      MemoryArena::Free(cache.memory);
+      return false;
+    }
+
+    bd->texPool.RegisterTexture(OverlayCacheTexId, &cache.texture, nullptr);
+    cache.texHandle = bd->device->GetTextureHandle(OverlayCacheTexId, bd->samplerId);
+
+    cache.width = width;
+    cache.height = height;
+    cache.isTextureReady = true;
+    cache.isValid = false;
+
+    return true;
+  }
+
+  // grows rect (x1, y1, x2, y2) to also cover other, empty rects are ignored
+  void unionRect(ImVec4 &rect, const ImVec4 &other) {
+
+    if (other.z <= other.x || other.w <= other.y) {
+      return;
+    }
+
+    if (rect.z <= rect.x || rect.w <= rect.y) {
+      rect = other;
+      return;
+    }
+
+    rect.x = other.x < rect.x ? other.x : rect.x;
+    rect.y = other.y < rect.y ? other.y : rect.y;
+    rect.z = other.z > rect.z ? other.z : rect.z;
+    rect.w = other.w > rect.w ? other.w : rect.w;
+  }
+
+  // everything a draw list can touch is inside the union of its commands' clip rects. lists clipped to the whole
+  // display (the foreground list with the mouse cursor, fullscreen windows) would dirty all of it on every change, so
+  // their bounds get narrowed down to their vertices
+  ImVec4 getDrawListBounds(ImDrawList *cmdList, const ImVec4 &displayRect) {
+
+    ImVec4 bounds(0.0f, 0.0f, 0.0f, 0.0f);
+    for (auto &cmd: cmdList->CmdBuffer) {
+      unionRect(bounds, cmd.ClipRect);
+    }
+
+    bool isFullscreen = bounds.x <= displayRect.x && bounds.y <= displayRect.y && bounds.z >= displayRect.z &&
+                        bounds.w >= displayRect.w;
+    if (!isFullscreen || cmdList->VtxBuffer.empty()) {
+      return bounds;
+    }
+
+    ImVec4 vtxBounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (auto &vtx: cmdList->VtxBuffer) {
+      vtxBounds.x = vtx.pos.x < vtxBounds.x ? vtx.pos.x : vtxBounds.x;
+      vtxBounds.y = vtx.pos.y < vtxBounds.y ? vtx.pos.y : vtxBounds.y;
+      vtxBounds.z = vtx.pos.x > vtxBounds.z ? vtx.pos.x : vtxBounds.z;
+      vtxBounds.w = vtx.pos.y > vtxBounds.w ? vtx.pos.y : vtxBounds.w;
+    }
+
+    // a list that is empty once clipped still gets a bounds covering nothing
+    bounds.x = vtxBounds.x > bounds.x ? vtxBounds.x : bounds.x;
+    bounds.y = vtxBounds.y > bounds.y ? vtxBounds.y : bounds.y;
+    bounds.z = vtxBounds.z < bounds.z ? vtxBounds.z : bounds.z;
+    bounds.w = vtxBounds.w < bounds.w ? vtxBounds.w : bounds.w;
+
+    return bounds;
+  }
+
+  // compares every draw list against the ones the cache currently holds, and computes the area that needs to be
+  // redrawn: the old and new bounds of every list that changed. returns false if the cache can't be used
+  bool updateOverlayCache(ImDrawData *drawData) {
+
+    auto bd = getBackendData();
+    OverlayCache &cache = bd->overlayCache;
+
+    int width = (int) drawData->DisplaySize.x;
+    int height = (int) drawData->DisplaySize.y;
+    if (!cache.isTextureReady || cache.width != width || cache.height != height) {
+      if (!setupOverlayCache(width, height)) {
+        return false;
+      }
+    }
+
+    ImVec4 dirtyRect(0.0f, 0.0f, 0.0f, 0.0f);
+    ImVec4 displayRect(drawData->DisplayPos.x, drawData->DisplayPos.y, drawData->DisplayPos.x + drawData->DisplaySize.x,
+                       drawData->DisplayPos.y + drawData->DisplaySize.y);
+
+    int listCount = drawData->CmdListsCount > cache.lists.Size ? drawData->CmdListsCount : cache.lists.Size;
+    for (int i = 0; i < listCount; i++) {
+      bool isInCache = i < cache.lists.Size;
+      bool isInFrame = i < drawData->CmdListsCount;
+
+      CachedDrawList current = {};
+      if (isInFrame) {
+        current.hash = hashDrawList(drawData->CmdLists[i], HashSeed);
+      }
+
+      if (isInCache && isInFrame && cache.lists[i].hash == current.hash) {
+        continue;
+      }
+
+      if (isInFrame) {
+        current.bounds = getDrawListBounds(drawData->CmdLists[i], displayRect);
+      }
+
+      if (isInCache) {
+        unionRect(dirtyRect, cache.lists[i].bounds);
+      }
+      unionRect(dirtyRect, current.bounds);
+
+      if (isInFrame) {
+        if (isInCache) {
+          cache.lists[i] = current;
+        } else {
+          cache.lists.push_back(current);
+        }
+      }
+    }
+
+    cache.lists.resize(drawData->CmdListsCount);
+
+    if (!cache.isValid) {
+      dirtyRect = ImVec4(0.0f, 0.0f, (float) width, (float) height);
+      cache.isValid = true;
+    }
+
+    // snap outwards to whole pixels, and keep it inside of the cache
+    int x1 = (int) floorf(dirtyRect.x), y1 = (int) floorf(dirtyRect.y);
+    int x2 = (int) ceilf(dirtyRect.z), y2 = (int) ceilf(dirtyRect.w);
+    x1 = x1 < 0 ? 0 : x1;
+    y1 = y1 < 0 ? 0 : y1;
+    x2 = x2 > width ? width : x2;
+    y2 = y2 > height ? height : y2;
+
+    cache.dirtyRect[0] = x1;
+    cache.dirtyRect[1] = y1;
+    cache.dirtyRect[2] = x2 > x1 ? x2 - x1 : 0;
+    cache.dirtyRect[3] = y2 > y1 ? y2 - y1 : 0;
+
+    if (cache.dirtyRect[2] == 0 || cache.dirtyRect[3] == 0) {
+      cache.skippedFrames++;
+    } else {
+      cache.redrawnFrames++;
+    }
+
+    return true;
+  }
+
+  // restricts the frame's batches to rect (x, y, w, h), dropping the ones completely outside of it
+  void clipBatches(const int rect[4]) {
+
+    auto bd = getBackendData();
+
+    int count = 0;
+    for (auto &batch: bd->drawBatches) {
+      int x1 = batch.scissor[0] > rect[0] ? batch.scissor[0] : rect[0];
+      int y1 = batch.scissor[1] > rect[1] ? batch.scissor[1] : rect[1];
+      int x2 = batch.scissor[0] + batch.scissor[2] < rect[0] + rect[2] ? batch.scissor[0] + batch.scissor[2]
+                                                                          : rect[0] + rect[2];
+      int y2 = batch.scissor[1] + batch.scissor[3] < rect[1] + rect[3] ? batch.scissor[1] + batch.scissor[3]
+                                                                          : rect[1] + rect[3];
+      if (x2 <= x1 || y2 <= y1) {
+        continue;
+      }
+
+      DrawBatch clipped = batch;
+      clipped.scissor[0] = x1;
+      clipped.scissor[1] = y1;
+      clipped.scissor[2] = x2 - x1;
+      clipped.scissor[3] = y2 - y1;
+      // the dirty rect might cut through its vertices now
+      clipped.isInsideScissor = batch.isInsideScissor &&
+                                memcmp(clipped.scissor, batch.scissor, sizeof(batch.scissor)) == 0;
+      bd->drawBatches[count++] = clipped;
+    }
+
+    bd->drawBatches.resize(count);
+  }
+
+  // writes a quad covering the whole display, sampling the overlay cache 1:1
+  void writeCompositeQuad(ImDrawVert *vtxDst, ImDrawIdx *idxDst) {
+
+    auto bd = getBackendData();
+    auto w = (float) bd->overlayCache.width;
+    auto h = (float) bd->overlayCache.height;
+
+    // with a lower left origin, the top of the screen ends up in the last row of the texture
+    bool isFlipped = bd->device->GetWindowOriginMode() == nvn::WindowOriginMode::LOWER_LEFT;
+    float v0 = isFlipped ? 1.0f : 0.0f;
+    float v1 = isFlipped ? 0.0f : 1.0f;
+
+    vtxDst[0] = {ImVec2(0.0f, 0.0f), ImVec2(0.0f, v0), IM_COL32_WHITE};
+    vtxDst[1] = {ImVec2(w, 0.0f), ImVec2(1.0f, v0), IM_COL32_WHITE};
+    vtxDst[2] = {ImVec2(w, h), ImVec2(1.0f, v1), IM_COL32_WHITE};
+    vtxDst[3] = {ImVec2(0.0f, h), ImVec2(0.0f, v1), IM_COL32_WHITE};
+
+    static constexpr ImDrawIdx quadIndices[CompositeIdxCount] = {0, 1, 2, 0, 2, 3};
+    memcpy(idxDst, quadIndices, sizeof(quadIndices));
+  }
+
+  // draws the overlay cache onto the texture that is about to be presented
+  void compositeOverlayCache(FrameResources &frame, int quadVtxOffset, int quadIdxOffset) {
+
+    auto bd = getBackendData();
+    OverlayCache &cache = bd->overlayCache;
+
+    const nvn::Texture *target = bd->presentTarget;
+    bd->cmdBuf->SetRenderTargets(1, &target, nullptr, nullptr, nullptr);
+
+    // the cache was just rendered to, make sure those writes land before it gets sampled
+    bd->cmdBuf->Barrier(nvn::BarrierBits::ORDER_FRAGMENTS | nvn::BarrierBits::INVALIDATE_TEXTURE);
+
+    setScissor(0, 0, cache.width, cache.height);
+    bindBlendState(&bd->compositeBlendState);
+    bindTexture(cache.texHandle);
+
+    bd->cmdBuf->DrawElementsBaseVertex(nvn::DrawPrimitive::TRIANGLES, DrawIdxType, CompositeIdxCount,
+                                       (*frame.idxBuffer.memory) + quadIdxOffset * sizeof(ImDrawIdx),
+                                       quadVtxOffset);
+  }
+
+  // records one direct draw per batch
+  void drawBatches(FrameResources &frame) {
+
+    auto bd = getBackendData();
+
+    for (auto &batch: bd->drawBatches) {
+
+      setScissor(batch.scissor[0], batch.scissor[1], batch.scissor[2], batch.scissor[3]);
+
+      // only bound if it differs from the current texture
+      bindTexture(batch.texture);
+
+      // draw our vertices using the indices stored in the buffer, offset by the batch's global index offset.
+      bd->cmdBuf->DrawElementsBaseVertex(nvn::DrawPrimitive::TRIANGLES, DrawIdxType, batch.elemCount,
+                                         (*frame.idxBuffer.memory) + batch.idxOffset * sizeof(ImDrawIdx),
+                                         batch.vtxOffset);
+    }
+
+    bd->drawStats.drawCalls = bd->drawBatches.Size;
+  }
+
+  // writes the draw arguments of every batch into the frame's indirect buffer, then records a single
+  // MultiDrawElementsIndirectCount for each run of batches sharing a texture. addDrawBatch already merged the
+  // batches sharing a scissor too, so runs only get longer than one batch by ignoring the scissor: batches inside of
+  // their scissor get drawn with the union of the run's scissors, the others still need a run of their own scissor.
+  // the buffer holds all the draw arguments first, followed by one draw count per run.
+  bool drawBatchesIndirect(FrameResources &frame) {
+
+    auto bd = getBackendData();
+
+    int batchCount = bd->drawBatches.Size;
+    size_t argsSize = batchCount * sizeof(DrawElementsIndirectData);
+
+    // there can't be more runs than batches, so size the counts for the worst case
+    if (!growStreamBuffer(frame.indirectBuffer, argsSize + batchCount * sizeof(int), bd->indirectStats,
+                          "Indirect")) {
+      Logger::log("Indirect Buffer is not Ready! Falling back to Direct Draws.\n");
+      return false;
+    }
+
+    auto args = (DrawElementsIndirectData *) frame.indirectBuffer.memory->GetMemPtr();
+    auto counts = (int *) (frame.indirectBuffer.memory->GetMemPtr() + argsSize);
+
+    nvn::BufferAddress argsAddress = *frame.indirectBuffer.memory;
+    nvn::BufferAddress countsAddress = argsAddress + argsSize;
+
+    int runCount = 0;
+    int runStart = 0;
+    while (runStart < batchCount) {
+      DrawBatch &first = bd->drawBatches[runStart];
+
+      // scissor of the run, as (x1, y1, x2, y2)
+      int runScissor[4] = {first.scissor[0], first.scissor[1], first.scissor[0] + first.scissor[2],
+                           first.scissor[1] + first.scissor[3]};
+
+      int runEnd = runStart;
+      while (runEnd < batchCount) {
+        DrawBatch &batch = bd->drawBatches[runEnd];
+        if (batch.texture != first.texture) {
+          break;
+        }
+
+        if (first.isInsideScissor) {
+          if (!batch.isInsideScissor) {
+            break;
+          }
+          runScissor[0] = batch.scissor[0] < runScissor[0] ? batch.scissor[0] : runScissor[0];
+          runScissor[1] = batch.scissor[1] < runScissor[1] ? batch.scissor[1] : runScissor[1];
+          runScissor[2] = batch.scissor[0] + batch.scissor[2] > runScissor[2] ? batch.scissor[0] + batch.scissor[2]
+                                                                              : runScissor[2];
+          runScissor[3] = batch.scissor[1] + batch.scissor[3] > runScissor[3] ? batch.scissor[1] + batch.scissor[3]
+                                                                              : runScissor[3];
+        } else if (memcmp(batch.scissor, first.scissor, sizeof(first.scissor)) != 0) {
+          break;
+        }
+
+        args[runEnd] = {
+            .count = batch.elemCount,
+            .instanceCount = 1,
+            .firstIndex = batch.idxOffset,
+            .baseVertex = batch.vtxOffset,
+            .baseInstance = 0
+        };
+        runEnd++;
+      }
+
+      int drawCount = runEnd - runStart;
+      counts[runCount] = drawCount;
+
+      setScissor(runScissor[0], runScissor[1], runScissor[2] - runScissor[0], runScissor[3] - runScissor[1]);
+      bindTexture(first.texture);
+
+      bd->cmdBuf->MultiDrawElementsIndirectCount(nvn::DrawPrimitive::TRIANGLES, DrawIdxType, *frame.idxBuffer.memory,
+                                                 argsAddress + runStart * sizeof(DrawElementsIndirectData),
+                                                 countsAddress + runCount * sizeof(int), drawCount,
+                                                 sizeof(DrawElementsIndirectData));
+
+      runCount++;
+      runStart = runEnd;
+    }
+
+    bd->drawStats.drawCalls = runCount;
+
+    return true;
   }
 
   void renderDrawData(ImDrawData *drawData) {
@@ -639,9 +2457,11 @@ namespace ImguiNvnBackend {
       return;
     }
 
-    // get both the main backend data and IO from ImGui
+    // get the main backend data. the display size comes from the draw data, ImGui's IO might already be building the
+    // next frame (see IMGUI_XENO_ASYNC_FRAMES)
     auto bd = getBackendData();
-    ImGuiIO &io = ImGui::GetIO();
+
+    nn::os::Tick startTick = nn::os::GetSystemTick();
 
     // if something went wrong during backend setup, don't try to render anything
     if (!bd->isInitialized) {
@@ -649,52 +2469,62 @@ namespace ImguiNvnBackend {
       return;
     }
 
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+    updateTextures(drawData);
+#endif
+
+    if (bd->isCaptureRequested) {
+      writeCapture(drawData);
+    }
+
     // disable imgui rendering if we are using the test shader code
     if (bd->isUseTestShader) {
       renderTestShader(drawData);
       return;
     }
 
-    // initializes/resizes buffer used for all vertex data created by ImGui
-    size_t totalVtxSize = drawData->TotalVtxCount * sizeof(ImDrawVert);
-    if (!bd->vtxBuffer || bd->vtxBuffer->GetPoolSize() < totalVtxSize) {
-      if (bd->vtxBuffer) {
-        bd->vtxBuffer->Finalize();
-        IM_FREE(bd->vtxBuffer);
-        Logger::log("Resizing Vertex Buffer to Size: %d\n", totalVtxSize);
-      } else {
-        Logger::log("Initializing Vertex Buffer to Size: %d\n", totalVtxSize);
-      }
+    applyInvalidations();
 
-      bd->vtxBuffer = IM_NEW(MemoryBuffer)(totalVtxSize);
+#if IMGUI_XENO_REPLAY_UNCHANGED_FRAMES
+    u64 drawHash = hashDrawData(drawData);
+    if (bd->recordedFrame.isValid && bd->recordedFrame.hash == drawHash) {
+      replayRecordedFrame(drawData);
+      bd->recordMs = getElapsedMs(startTick);
+      return;
     }
+#endif
 
-    // initializes/resizes buffer used for all index data created by ImGui
-    size_t totalIdxSize = drawData->TotalIdxCount * sizeof(ImDrawIdx);
-    if (!bd->idxBuffer || bd->idxBuffer->GetPoolSize() < totalIdxSize) {
-      if (bd->idxBuffer) {
-
-        bd->idxBuffer->Finalize();
-        IM_FREE(bd->idxBuffer);
-
-        Logger::log("Resizing Index Buffer to Size: %d\n", totalIdxSize);
-      } else {
-        Logger::log("Initializing Index Buffer to Size: %d\n", totalIdxSize);
-      }
-
-      bd->idxBuffer = IM_NEW(MemoryBuffer)(totalIdxSize);
+    bool isUseCache = false;
+#if IMGUI_XENO_OVERLAY_CACHE
+    // compositing needs the texture being presented, if the window's textures weren't captured just draw directly
+    isUseCache = bd->presentTarget && updateOverlayCache(drawData);
+#endif
+    OverlayCache &cache = bd->overlayCache;
 
-    }
+    // grab the oldest frame in the ring, waiting for the GPU to finish with it if needed.
+    // its buffers can then be resized or overwritten without touching geometry that is still in flight
+    FrameResources &frame = acquireFrame();
 
+    // initializes/resizes the buffers used for all vertex and index data created by ImGui.
     // if we fail to resize/init either buffers, end execution before we try to use said invalid buffer(s)
-    if (!(bd->vtxBuffer->IsBufferReady() && bd->idxBuffer->IsBufferReady())) {
+    size_t totalVtxSize = (drawData->TotalVtxCount + (isUseCache ? CompositeVtxCount : 0)) * sizeof(ImDrawVert);
+    size_t totalIdxSize = (drawData->TotalIdxCount + (isUseCache ? CompositeIdxCount : 0)) * sizeof(ImDrawIdx);
+    if (!growStreamBuffer(frame.vtxBuffer, totalVtxSize, bd->vtxStats, "Vertex") ||
+        !growStreamBuffer(frame.idxBuffer, totalIdxSize, bd->idxStats, "Index")) {
       Logger::log("Cannot Draw Data! Buffers are not Ready.\n");
       return;
     }
 
-    orthoRH_ZO(projMatrix, 0.0f, io.DisplaySize.x, io.DisplaySize.y, 0.0f, -1.0f, 1.0f);
+    // the backend only draws the main viewport, so DisplayPos is always at the origin
+    ImVec2 displaySize = drawData->DisplaySize;
+    orthoRH_ZO(projMatrix, 0.0f, displaySize.x, displaySize.y, 0.0f, -1.0f, 1.0f);
 
-    bd->cmdBuf->BeginRecording(); // start recording our commands to the cmd buffer
+    // start recording our commands to the cmd buffer, into the command memory of this frame
+    if (!beginFrameCommands(frame)) {
+      Logger::log("Cannot Draw Data! Command Memory is not Ready.\n");
+      return;
+    }
+    resetStateCache();
 
     bd->cmdBuf->BindProgram(&bd->shaderProgram, nvn::ShaderStageBits::VERTEX |
                                                 nvn::ShaderStageBits::FRAGMENT); // bind main imgui shader
@@ -706,10 +2536,40 @@ namespace ImguiNvnBackend {
 
     setRenderStates(); // sets up the rest of the render state, required so that our shader properly gets drawn to the screen
 
-    size_t vtxOffset = 0, idxOffset = 0;
-    nvn::TextureHandle boundTextureHandle = 0;
+    if (isUseCache) {
+      // draw into the cache instead, which keeps premultiplied colors so it can be composited in one pass
+      const nvn::Texture *target = &cache.texture;
+      bd->cmdBuf->SetRenderTargets(1, &target, nullptr, nullptr, nullptr);
+      bindBlendState(&bd->cacheBlendState);
+    }
+
+    // the viewport covers the whole display for every command, only set it once
+    setViewport(0, 0, (int) displaySize.x, (int) displaySize.y);
+
+    if (isUseCache && cache.dirtyRect[2] > 0 && cache.dirtyRect[3] > 0) {
+      // clears are scissored too, so only the dirty area is wiped
+      static constexpr float clearColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+      setScissor(cache.dirtyRect[0], cache.dirtyRect[1], cache.dirtyRect[2], cache.dirtyRect[3]);
+      bd->cmdBuf->ClearColor(0, clearColor, nvn::ClearColorMask::RGBA);
+    }
+
+    // the whole frame's vertices live in a single buffer, so it only needs to be bound once.
+    // draws then index into it using the global vertex/index offset of their command list
+    bindVertexBuffer(*frame.vtxBuffer.memory, totalVtxSize);
+
+    int globalVtxOffset = 0, globalIdxOffset = 0;
+
+    bd->drawBatches.resize(0);
+    bd->drawStats.cmdsIn = 0;
+    bd->drawStats.vtxCount = drawData->TotalVtxCount;
+    bd->drawStats.idxCount = drawData->TotalIdxCount;
+    bd->drawStats.isReplayed = false;
 
-    // load data into buffers, and process draw commands
+    // if every vertex of the frame can be addressed by ImDrawIdx, indices are rebased while uploading, so all draws
+    // share a base vertex of 0 and can be merged across command lists too
+    bool rebaseIndices = (size_t) drawData->TotalVtxCount <= MaxIndexedVertices;
+
+    // load data into buffers, and merge draw commands into batches
     for (int i = 0; i < drawData->CmdListsCount; i++) {
 
       auto cmdList = drawData->CmdLists[i];
@@ -718,58 +2578,62 @@ namespace ImguiNvnBackend {
       size_t vtxSize = cmdList->VtxBuffer.Size * sizeof(ImDrawVert);
       size_t idxSize = cmdList->IdxBuffer.Size * sizeof(ImDrawIdx);
 
-      // bind vtx buffer at the current offset
-      bd->cmdBuf->BindVertexBuffer(0, (*bd->vtxBuffer) + vtxOffset, vtxSize);
-
       // copy data from imgui command list into our gpu dedicated memory
-      memcpy(bd->vtxBuffer->GetMemPtr() + vtxOffset, cmdList->VtxBuffer.Data, vtxSize);
-      memcpy(bd->idxBuffer->GetMemPtr() + idxOffset, cmdList->IdxBuffer.Data, idxSize);
-
-      for (auto cmd: cmdList->CmdBuffer) {
-
+      uploadToStream(frame.vtxBuffer.memory->GetMemPtr() + globalVtxOffset * sizeof(ImDrawVert),
+                     cmdList->VtxBuffer.Data, vtxSize);
 
-//                ImVec2 origRes(1280.0f, 720.0f);
-//                ImVec2 newRes = io.DisplaySize; // (1600.0f, 900.0f);
+      auto idxDst = frame.idxBuffer.memory->GetMemPtr() + globalIdxOffset * sizeof(ImDrawIdx);
+      if (rebaseIndices && globalVtxOffset != 0) {
+        uploadRebasedIndices((ImDrawIdx *) idxDst, cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size,
+                             globalVtxOffset);
+      } else {
+        uploadToStream(idxDst, cmdList->IdxBuffer.Data, idxSize);
+      }
 
-        // clipping seems to be a bit more broken here than in my other repo, not exactly sure what's changed, but it's disabled for now.
+      for (auto &cmd: cmdList->CmdBuffer) {
+        bd->drawStats.cmdsIn++;
+        addDrawBatch(cmdList, cmd, rebaseIndices ? 0 : globalVtxOffset, globalIdxOffset);
+      }
 
-        ImVec4 clipRect = ImVec4(cmd.ClipRect.x,
-                                 cmd.ClipRect.y,
-                                 cmd.ClipRect.z,
-                                 cmd.ClipRect.w);
+      globalVtxOffset += cmdList->VtxBuffer.Size;
+      globalIdxOffset += cmdList->IdxBuffer.Size;
+    }
 
-        ImVec2 clip_min(clipRect.x, clipRect.y);
-        ImVec2 clip_max(clipRect.z, clipRect.w);
-        ImVec2 clip_size(clip_max.x - clip_min.x, clip_max.y - clip_min.y);
+    if (isUseCache) {
+      // only the dirty area of the cache gets redrawn, everything else is still valid from previous frames
+      clipBatches(cache.dirtyRect);
 
-        if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
-          continue;
+      writeCompositeQuad((ImDrawVert *) (frame.vtxBuffer.memory->GetMemPtr() + globalVtxOffset * sizeof(ImDrawVert)),
+                         (ImDrawIdx *) (frame.idxBuffer.memory->GetMemPtr() + globalIdxOffset * sizeof(ImDrawIdx)));
+    }
 
-        bd->cmdBuf->SetViewport(0, 0, io.DisplaySize.x, io.DisplaySize.y);
-        bd->cmdBuf->SetScissor((int) clip_min.x, (int) clip_min.y,(int) clip_size.x, (int) clip_size.y);
-        //bd->cmdBuf->SetScissor(0, 0, io.DisplaySize.x, io.DisplaySize.y);
+    bd->drawStats.drawsOut = bd->drawBatches.Size;
 
-        // get texture ID from the command
-        nvn::TextureHandle TexID = *(nvn::TextureHandle *) cmd.GetTexID();
-        // if our previous handle is different from the current, bind the texture
-        if (boundTextureHandle != TexID) {
-          boundTextureHandle = TexID;
-          bd->cmdBuf->BindTexture(nvn::ShaderStage::FRAGMENT, 0, TexID);
-        }
-        // draw our vertices using the indices stored in the buffer, offset by the current command index offset,
-        // as well as the current offset into our buffer.
-        bd->cmdBuf->DrawElementsBaseVertex(nvn::DrawPrimitive::TRIANGLES,
-                                           nvn::IndexType::UNSIGNED_SHORT, cmd.ElemCount,
-                                           (*bd->idxBuffer) + (cmd.IdxOffset * sizeof(ImDrawIdx)) + idxOffset,
-                                           cmd.VtxOffset);
-      }
+    if (!bd->drawBatches.empty()) {
+#if IMGUI_XENO_INDIRECT_DRAWS
+      if (!drawBatchesIndirect(frame))
+#endif
+        drawBatches(frame);
+    }
 
-      vtxOffset += vtxSize;
-      idxOffset += idxSize;
+    if (isUseCache) {
+      compositeOverlayCache(frame, globalVtxOffset, globalIdxOffset);
     }
+    bd->drawStats.skippedBinds = bd->stateCache.skippedBinds;
 
     // end the command recording and submit to queue.
-    auto handle = bd->cmdBuf->EndRecording();
-    bd->queue->SubmitCommands(1, &handle);
+#if IMGUI_XENO_REPLAY_UNCHANGED_FRAMES
+    bd->recordedFrame.handle = submitFrameCommands();
+    bd->recordedFrame.hash = drawHash;
+    bd->recordedFrame.frameIndex = bd->frameIndex;
+    bd->recordedFrame.isValid = true;
+#else
+    submitFrameCommands();
+#endif
+
+    // fence this frame's buffers and move on to the next slot in the ring
+    releaseFrame(frame);
+
+    bd->recordMs = getElapsedMs(startTick);
   }
 }
\ No newline at end of file
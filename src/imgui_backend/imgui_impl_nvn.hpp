@@ -8,7 +8,10 @@
 #include "nvn_CppMethods.h"
 #include "types.h"
 #include "MemoryBuffer.h"
+#include "imgui_backend_config.h"
+#include "xeno_types.h"
 
+#include "nn/os.h"
 #include "os/os_tick.hpp"
 
 #ifdef __cplusplus
@@ -18,10 +21,227 @@ namespace ImguiNvnBackend {
   static constexpr int MaxTexDescriptors = 256 + 100;
   static constexpr int MaxSampDescriptors = 256 + 100;
 
+  static constexpr int FramesInFlight = IMGUI_XENO_FRAMES_IN_FLIGHT;
+
+  // descriptor slot of the overlay cache texture, sampled with the font sampler
+  static constexpr int OverlayCacheTexId = 258;
+  static constexpr int CompositeVtxCount = 4;
+  static constexpr int CompositeIdxCount = 6;
+
+  // ImDrawIdx can be switched to 32-bit in imgui_user_config.h, for lists with more than 64k vertices
+  static_assert(sizeof(ImDrawIdx) == 2 || sizeof(ImDrawIdx) == 4, "Unsupported ImDrawIdx size");
+  static constexpr nvn::IndexType::Enum DrawIdxType = sizeof(ImDrawIdx) == 2 ? nvn::IndexType::UNSIGNED_SHORT
+                                                                             : nvn::IndexType::UNSIGNED_INT;
+  static constexpr size_t MaxIndexedVertices = (size_t) (ImDrawIdx) -1 + 1;
+
+  // initial size of the command/control memory of each frame, grown if a frame needed more
+  static constexpr size_t CommandMemorySize = 0x10000;
+  static constexpr size_t ControlMemorySize = 0x1000;
+
+  // streaming buffers grow by at least this factor, so slowly growing windows don't reallocate every frame
+  static constexpr float BufferGrowthFactor = 1.5f;
+  // how many retired streaming buffers are kept around for reuse before the smallest one gets freed
+  static constexpr int MaxRetiredBuffers = 4;
+
+  struct StreamBuffer {
+    MemoryBuffer *memory;
+    // the size an exact-fit policy would have (re)allocated to, only used for stats
+    size_t exactFitSize;
+  };
+
+  struct StreamBufferStats {
+    size_t highWaterMark;
+    int allocations;
+    int reuses;
+    int avoidedReallocs;
+  };
+
+  // shadow copy of the state bound in the current recording, used to filter out redundant binds. a default
+  // constructed cache holds values no bind ever uses, as nothing is known to be bound at the start of a recording
+  struct RenderStateCache {
+    int viewport[4] = {-1, -1, -1, -1};
+    int scissor[4] = {-1, -1, -1, -1};
+    nvn::TextureHandle texture = 0;
+    nvn::BufferAddress vtxBufferAddress = ~(nvn::BufferAddress) 0;
+    size_t vtxBufferSize = ~(size_t) 0;
+    const nvn::BlendState *blendState = nullptr;
+
+    int skippedBinds = 0;
+  };
+
+  // one or more consecutive ImDrawCmds merged into a single draw
+  struct DrawBatch {
+    int scissor[4];
+    nvn::TextureHandle texture;
+    int vtxOffset;
+    int idxOffset;
+    int elemCount;
+    // every vertex lies inside the scissor, so any scissor containing it draws the same pixels. indirect draws group
+    // such batches by texture alone (only computed with IMGUI_XENO_INDIRECT_DRAWS)
+    bool isInsideScissor;
+  };
+
+  struct DrawStats {
+    int cmdsIn;
+    int drawsOut;
+    // draw commands actually recorded, lower than drawsOut when batches are submitted indirectly
+    int drawCalls;
+    int vtxCount;
+    int idxCount;
+    // binds the state cache left out, since the state was already set
+    int skippedBinds;
+    // the last recording got submitted again, so nothing was merged, recorded or bound
+    bool isReplayed;
+  };
+
+  // argument layout expected by DrawElementsIndirect/MultiDrawElementsIndirectCount
+  struct DrawElementsIndirectData {
+    int count;
+    int instanceCount;
+    int firstIndex;
+    int baseVertex;
+    int baseInstance;
+  };
+
+  struct ControlBlock {
+    void *ptr;
+    size_t size;
+  };
+
+  // memory a frame's commands are recorded into. extra blocks are added by the memory callback when it runs out
+  struct CommandMemory {
+    ImVector<MemoryArena::Allocation> commandBlocks;
+    ImVector<ControlBlock> controlBlocks;
+    size_t commandSize;
+    size_t controlSize;
+  };
+
+  // streaming memory owned by a single in-flight frame, only reused once its fence has been signaled
+  struct FrameResources {
+    StreamBuffer vtxBuffer;
+    StreamBuffer idxBuffer;
+    // draw arguments and counts, only used with IMGUI_XENO_INDIRECT_DRAWS
+    StreamBuffer indirectBuffer;
+
+    CommandMemory cmdMemory;
+    // commands recorded ahead of the frame's draws (begin timestamp, texture uploads), kept out of the recording of the
+    // draws so a replay of it doesn't run them again
+    nvn::CommandHandle beginHandle;
+
+    // GPU timestamps around the frame's commands, read back once its fence signals
+    MemoryBuffer *timestampBuffer;
+    bool hasTimestamps;
+
+    nvn::Sync fence;
+    bool isFenceSubmitted;
+    // number of the last frame recorded into this slot, counting from 1 (see submittedFrames)
+    u64 serial;
+    // staging ring position the frame's texture copies end at, the space before it is free once the fence signals
+    u64 stagingEnd;
+  };
+
+  // the last command stream recorded by renderDrawData, resubmitted as long as the draw data hashes the same
+  struct RecordedFrame {
+    nvn::CommandHandle handle;
+    u64 hash;
+    // ring slot holding the geometry referenced by the recording
+    int frameIndex;
+    bool isValid;
+
+    int replayCount;
+  };
+
+  // state of a draw list as it was last drawn into the overlay cache
+  struct CachedDrawList {
+    u64 hash;
+    // (x1, y1, x2, y2)
+    ImVec4 bounds;
+  };
+
+  // offscreen copy of the overlay, only redrawn where draw lists changed and then composited onto the presented
+  // texture with a single quad
+  struct OverlayCache {
+    nvn::Texture texture;
+    MemoryArena::Allocation memory;
+    nvn::TextureHandle texHandle;
+    int width;
+    int height;
+    bool isTextureReady;
+    // cleared when the contents can't be trusted anymore, so the next frame redraws everything
+    bool isValid;
+
+    ImVector<CachedDrawList> lists;
+    // area redrawn this frame (x, y, w, h), empty if nothing changed
+    int dirtyRect[4];
+
+    int redrawnFrames;
+    int skippedFrames;
+  };
+
+  // descriptor slots handed out at runtime, to the textures ImGui creates itself (see IMGUI_XENO_DYNAMIC_FONT_ATLAS)
+  // and to user textures. the font and the overlay cache keep the fixed slots below
+  static constexpr int FirstDynamicTexId = 259;
+
+  static constexpr int MaxUserTextures = IMGUI_XENO_MAX_USER_TEXTURES;
+  // a repacked atlas is created before the previous one gets destroyed, so ImGui needs a few slots of its own
+  static_assert(MaxUserTextures <= MaxTexDescriptors - FirstDynamicTexId - 4, "Too many user textures");
+
+  // GPU side of an ImTextureData, set as its BackendUserData
+  struct ManagedTexture {
+    nvn::Texture texture;
+    MemoryArena::Allocation memory;
+    nvn::TextureHandle texHandle;
+    int textureId;
+  };
+
+  // texture registered with createUserTexture. its texture ID points to texHandle, which keeps the same value for the
+  // texture's whole life
+  struct UserTexture {
+    nvn::Texture texture;
+    MemoryArena::Allocation memory;
+    nvn::TextureHandle texHandle;
+    int textureId;
+    int width;
+    int height;
+    ImguiXenoTextureFormat format;
+    // part of the handles given out, so handles of destroyed textures don't reach the texture reusing their entry
+    u16 generation;
+    bool isUsed;
+    // destroyed, but frames the GPU hasn't finished yet might still sample it
+    bool isPendingFree;
+    // serial of the last frame that drew with the texture
+    u64 lastUseSerial;
+  };
+
+  static constexpr size_t StagingSize = IMGUI_XENO_STAGING_SIZE;
+  static constexpr size_t StagingAlignment = 0x100;
+
+  // texels waiting in the staging ring, copied into their texture by the next recorded frame
+  struct TextureUpload {
+    const nvn::Texture *texture;
+    nvn::CopyRegion region;
+    // ring position of the first row, and bytes between rows
+    u64 pos;
+    ptrdiff_t rowPitch;
+  };
+
+  // texel updates are written to this memory by the CPU, then copied into their texture by the GPU in frame order, so
+  // updating a texture never has to wait for frames still sampling it. allocated with the frame resources
+  struct StagingRing {
+    MemoryBuffer *memory;
+    // positions only ever increase, they are wrapped by StagingSize to address the memory.
+    // everything before flushedPos is copied by a recorded frame, and everything before releasePos by a finished one
+    u64 writePos;
+    u64 flushedPos;
+    u64 releasePos;
+    ImVector<TextureUpload> uploads;
+    // updates that didn't fit in the ring when they were made
+    int overflows;
+  };
+
   struct NvnBackendInitInfo {
     nvn::Device *device;
     nvn::Queue *queue;
-    nvn::CommandBuffer *cmdBuf;
   };
 
   struct NvnBackendData {
@@ -32,6 +252,24 @@ namespace ImguiNvnBackend {
     nvn::Queue *queue;
     nvn::CommandBuffer *cmdBuf;
 
+    // command buffer owned by the backend, its memory is handed out per frame (see FrameResources)
+
+    nvn::CommandBuffer commandBuffer;
+    int cmdMemAlignment;
+    int ctrlMemAlignment;
+    FrameResources *recordingFrame;
+
+    // pools used by the game, restored at the end of our commands
+
+    const nvn::TexturePool *gameTexPool;
+    const nvn::SamplerPool *gameSamplerPool;
+
+    // memory arenas, one per set of MemoryPoolFlags. user textures allocate from any thread, so they are locked with
+    // arenaMutex (see MemoryArena::Allocate)
+
+    ImVector<MemoryArena *> arenas;
+    nn::os::MutexType arenaMutex;
+
     // builders
 
     nvn::BufferBuilder bufferBuilder;
@@ -51,14 +289,24 @@ namespace ImguiNvnBackend {
     nvn::VertexStreamState streamState;
     nvn::VertexAttribState attribStates[3];
 
+    // render states, built once during setup
+
+    nvn::PolygonState polyState;
+    nvn::ColorState colorState;
+    nvn::BlendState blendState;
+    nvn::BlendState cacheBlendState;
+    nvn::BlendState compositeBlendState;
+
+    RenderStateCache stateCache;
+
     // font data
 
     nvn::TexturePool texPool;
     nvn::SamplerPool samplerPool;
 
-    nvn::MemoryPool sampTexMemPool;
+    MemoryArena::Allocation sampTexMemory;
 
-    nvn::MemoryPool fontMemPool;
+    MemoryArena::Allocation fontMemory;
 
     int samplerId;
     nvn::Sampler fontSampler;
@@ -67,10 +315,54 @@ namespace ImguiNvnBackend {
 
     nvn::TextureHandle fontTexHandle;
 
+    // texels or descriptors were written since the last recorded frame, so the GPU's caches need to be invalidated.
+    // locked with textureMutex
+    bool hasTextureWrites;
+    // set from any thread, and applied by the render thread before its next frame (see applyInvalidations). locked
+    // with textureMutex
+    bool isRecordedFrameStale;
+    bool isOverlayCacheStale;
+
+    // descriptor slots from FirstDynamicTexId up, the lowest free one is at the back
+    ImVector<int> freeTexIds;
+    UserTexture userTextures[MaxUserTextures];
+    StagingRing stagingRing;
+    // user textures can be created and destroyed from any thread, the free lists, entries, staging ring and frame serials
+    // are locked with it
+    nn::os::MutexType textureMutex;
+
     // render data
 
-    MemoryBuffer *vtxBuffer;
-    MemoryBuffer *idxBuffer;
+    FrameResources frames[FramesInFlight];
+    int frameIndex;
+    // frames recorded so far, and the serial of the last one the GPU is known to have finished
+    u64 submittedFrames;
+    u64 completedFrames;
+
+    // buffers replaced by a bigger one, picked back up when another frame needs to grow.
+    // they come from a frame whose fence was already waited on, so the GPU is done with them
+    ImVector<MemoryBuffer *> retiredBuffers;
+
+    StreamBufferStats vtxStats;
+    StreamBufferStats idxStats;
+    StreamBufferStats indirectStats;
+
+    ImVector<DrawBatch> drawBatches;
+    DrawStats drawStats;
+
+    // CPU time of the last renderDrawData call, and GPU time of the last frame the GPU finished
+    float recordMs;
+    float gpuMs;
+
+    RecordedFrame recordedFrame;
+
+    // the next frame's draw data gets written to capturePath (see requestCapture)
+    bool isCaptureRequested;
+    char capturePath[0x100];
+
+    // texture the current frame is presented with, captured from the window's textures
+    nvn::Texture *presentTarget;
+    OverlayCache overlayCache;
 
     // misc data
 
@@ -78,6 +370,7 @@ namespace ImguiNvnBackend {
     bool isInitialized;
 
     bool isDisableInput = true;
+    bool isInputPolled;
 
     CompiledData imguiShaderBinary;
 
@@ -90,12 +383,43 @@ namespace ImguiNvnBackend {
     CompiledData testShaderBinary;
   };
 
+  // texture IDs point to the nvn::TextureHandle to bind. ImTextureID is a pointer before ImGui 1.92, and an integer
+  // since then
+  inline ImTextureID toTexId(const nvn::TextureHandle *texHandle) {
+    return (ImTextureID) (intptr_t) texHandle;
+  }
+
+  inline float getElapsedMs(nn::os::Tick startTick) {
+    return (float) (nn::os::GetSystemTick() - startTick).ToTimeSpan().GetNanoSeconds() / 1e6f;
+  }
+
   bool createShaders();
 
   bool setupShaders(u8 *shaderBinary, ulong binarySize);
 
+  bool setupFontTexture();
+
   bool setupFont();
 
+  bool setupFrameResources();
+
+  bool setupCommandBuffer();
+
+  bool beginFrameCommands(FrameResources &frame);
+
+  nvn::CommandHandle submitFrameCommands();
+
+  void setGamePools(const nvn::TexturePool *texPool, const nvn::SamplerPool *samplerPool);
+
+  FrameResources &acquireFrame();
+
+  void releaseFrame(FrameResources &frame);
+
+  // blocks until the GPU is done with every frame in the ring. render thread only
+  void waitForFrames();
+
+  bool growStreamBuffer(StreamBuffer &stream, size_t requiredSize, StreamBufferStats &stats, const char *name);
+
   void InitBackend(const NvnBackendInitInfo &initInfo);
 
   void ShutdownBackend();
@@ -104,10 +428,45 @@ namespace ImguiNvnBackend {
 
   void newFrame();
 
+  // feeds the current pad/keyboard/mouse/touch state to ImGui, at most once per frame
+  void pollInput();
+
+  void setupRenderStates();
+
   void setRenderStates();
 
+  void resetStateCache();
+
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+  // creates, updates and destroys the textures ImGui asked for in the draw data (only the rectangles that changed get
+  // uploaded). called by renderDrawData, or by the render thread while the async worker is parked if the draw data
+  // gets copied before rendering
+  void updateTextures(ImDrawData *drawData);
+#endif
+
+  // user textures, see imgui_xeno_create_texture. they can be used from any thread
+  ImguiXenoTexture createUserTexture(int width, int height, ImguiXenoTextureFormat format, const void *data);
+
+  bool updateUserTexture(ImguiXenoTexture handle, int x, int y, int width, int height, const void *data, int pitch);
+
+  void destroyUserTexture(ImguiXenoTexture handle);
+
+  // the texture ID of a user texture points to its handle, nullptr if the texture doesn't exist
+  const nvn::TextureHandle *getUserTextureHandle(ImguiXenoTexture handle);
+
   void renderDrawData(ImDrawData *drawData);
 
+  // forces the next frame to be recorded again, for changes the draw data hash can't see (e.g. texture contents).
+  // can be called from any thread
+  void invalidateRecordedFrame();
+
+  void setPresentTarget(nvn::Texture *texture);
+
+  // dumps the draw data of the next rendered frame to path, or to a new file in IMGUI_XENO_CAPTURE_PATH if null
+  void requestCapture(const char *path);
+
+  bool setupOverlayCache(int width, int height);
+
   NvnBackendData *getBackendData();
 }; // namespace ImguiNvnBackend
 
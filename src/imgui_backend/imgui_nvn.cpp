@@ -1,41 +1,129 @@
 #include "imgui_nvn.h"
+#include "PanelWorkers.h"
+#include "ProcHookTable.h"
 #include "helpers/InputHelper.h"
 #include "helpers/memoryHelper.h"
 #include "imgui_backend/imgui_impl_nvn.hpp"
 #include "imgui_backend_config.h"
+#include "imgui_internal.h"
 #include "logger/Logger.hpp"
 #include "nvn_CppFuncPtrImpl.h"
 #include "nx/abort.h"
+#include "nn/os.h"
+#include <cstdio>
 
 nvn::Device *nvnDevice;
 nvn::Queue *nvnQueue;
-nvn::CommandBuffer *nvnCmdBuf;
 
-static nvn::CommandBuffer *__cmdBuf = nullptr;
 static const nvn::TexturePool *__texturePool = nullptr;
 static const nvn::SamplerPool *__samplerPool = nullptr;
 
+// textures of the last window built by the game, indexed by presentTexture's texIndex
+static constexpr int MaxWindowTextures = 4;
+static nvn::Texture *__windowTextures[MaxWindowTextures] = {};
+static int __windowTextureCount = 0;
+
 nvn::DeviceGetProcAddressFunc tempGetProcAddressFuncPtr;
 
-nvn::CommandBufferInitializeFunc tempBufferInitFuncPtr;
 nvn::DeviceInitializeFunc tempDeviceInitFuncPtr;
 nvn::QueueInitializeFunc tempQueueInitFuncPtr;
 nvn::QueuePresentTextureFunc tempPresentTexFunc;
 nvn::WindowSetCropFunc tempSetCropFunc;
+nvn::WindowBuilderSetTexturesFunc tempBuilderSetTexturesFunc;
 
 nvn::CommandBufferSetTexturePoolFunc tempCommandSetTexturePoolFunc;
 nvn::CommandBufferSetSamplerPoolFunc tempCommandSetSamplerPoolFunc;
 
 bool hasInitImGui = false;
-int commandBufferCount = 0;
+bool hasTriedInitImGui = false;
 
 namespace nvnImGui {
   ImVector<ProcDrawFunc> drawQueue;
   ImVector<InitFunc> initQueue;
 }
 
+// UI updates per second, 0 updates every frame, and a negative rate only updates on input or when requested
+static float __updateRate = IMGUI_XENO_UPDATE_RATE;
+static bool __isUpdateRequested = false;
+// set after each update if the user is interacting with a widget, to keep updating at full rate
+static bool __isInteracting = false;
+static nn::TimeSpanType __lastUpdate;
+static nn::TimeSpanType __lastInteraction;
+
+// budget bookkeeping of a draw callback, indexed like drawQueue
+struct CallbackState {
+  float lastMs;
+  // updates in a row the callback ran over budget, or under it while demoted
+  int overBudgetCount;
+  int underBudgetCount;
+  // the callback only runs once every `interval` updates
+  int interval;
+  int skippedUpdates;
+  bool hasRun;
+  // windows the callback submitted on its last run, and copies of their draw lists to draw on skipped updates
+  ImVector<ImGuiID> windowIds;
+  ImVector<ImDrawList *> cachedLists;
+};
+
+static ImVector<CallbackState *> __callbackStates;
+static float __callbackBudgetMs = IMGUI_XENO_CALLBACK_BUDGET_MS;
+#if IMGUI_VERSION_NUM < 18980
+static bool __isBudgetWarned = false;
+#endif
+// windows submitted so far in the current update, to tell which ones belong to the callback that just ran
+static ImVector<ImGuiWindow *> __activeWindows;
+
+// timings of the UI update being built, written by whichever thread builds it
+static ImguiXenoFrameStats __buildStats = {};
+
+static constexpr int StatsHistorySize = 120;
+
+// what getFrameStats and the stats window read: the last drawn frame, with the timings of the update it was built by
+// and the backend's stats, and a rolling history of the per-frame timings
+struct DrawnFrameStats {
+  ImguiXenoFrameStats stats;
+  float updateHistory[StatsHistorySize];
+  float recordHistory[StatsHistorySize];
+  float gpuHistory[StatsHistorySize];
+  int historyOffset;
+};
+
+// only written by the render thread, once a frame has been drawn (see pushFrameStats)
+static DrawnFrameStats __drawnStats = {};
+
+// size of the game's window crop, applied to ImGui's IO by the render thread before the next frame gets built (see
+// applyWindowCrop). with async frames, the worker might be in the middle of a frame when the game changes it
+static ImVec2 __cropSize = {};
+static bool __hasNewCrop = false;
+
+#if IMGUI_XENO_ASYNC_FRAMES
+// a frame's draw data, copied out of ImGui so the worker can build the next frame while this one gets drawn
+struct DrawDataSnapshot {
+  ImDrawData drawData;
+  // reused between frames, so copying only allocates when a list outgrows its previous size
+  ImVector<ImDrawList *> lists;
+  // timings of the update that built it, handed to the render thread along with the draw data
+  ImguiXenoFrameStats stats;
+};
+
+static nn::os::ThreadType __workerThread;
+static void *__workerStack = nullptr;
+// render thread -> worker: build the next frame
+static nn::os::EventType __kickEvent;
+// worker -> render thread: the frame is ready in the snapshot the render thread isn't reading
+static nn::os::EventType __readyEvent;
+
+static DrawDataSnapshot __snapshots[2];
+// only changed by the render thread while the worker is idle
+static int __readIdx = 0;
+static bool __isWorkerBusy = false;
+static bool __hasFrame = false;
+// the draw callbacks run on the worker while the render thread keeps drawing, so they read a copy of the drawn stats,
+// taken while the worker is idle
+static DrawnFrameStats __publishedStats = {};
+#endif
+
 void setTexturePool(nvn::CommandBuffer *cmdBuf, const nvn::TexturePool *pool) {
-  __cmdBuf = cmdBuf;
   __texturePool = pool;
 
   tempCommandSetTexturePoolFunc(cmdBuf, pool);
@@ -53,32 +141,42 @@ void setCrop(nvn::Window *window, int x, int y, int w, int h) {
 
   tempSetCropFunc(window, x, y, w, h);
 
-  if (hasInitImGui)
-    ImGui::GetIO().DisplaySize = ImVec2(w - x, h - y);
+  __cropSize = ImVec2(w - x, h - y);
+  __hasNewCrop = true;
 }
 
-void presentTexture(nvn::Queue *queue, nvn::Window *window, int texIndex) {
+// called by the render thread, which also sets the crop, before a frame is built. the async worker is idle then
+static void applyWindowCrop() {
+  if (__hasNewCrop) {
+    ImGui::GetIO().DisplaySize = __cropSize;
+    __hasNewCrop = false;
+  }
+}
 
-  // save state; modified by procDraw
-  auto *buf = __cmdBuf;
-  auto *pool = __texturePool;
-  auto *samplerPool = __samplerPool;
+void setWindowTextures(nvn::WindowBuilder *builder, int numTextures, nvn::Texture *const *textures) {
 
-  // end previous recording (we dont need to submit)
-  buf->EndRecording();
+  __windowTextureCount = numTextures < MaxWindowTextures ? numTextures : MaxWindowTextures;
+  for (int i = 0; i < __windowTextureCount; i++) {
+    __windowTextures[i] = textures[i];
+  }
 
-  if (hasInitImGui)
-    nvnImGui::procDraw();
+  tempBuilderSetTexturesFunc(builder, numTextures, textures);
+}
 
-  // restore state
-  buf->BeginRecording();
-  setTexturePool(buf, pool);
-  setSamplerPool(buf, samplerPool);
-  auto handle = buf->EndRecording();
-  queue->SubmitCommands(1, &handle);
+void presentTexture(nvn::Queue *queue, nvn::Window *window, int texIndex) {
 
-  // start new recording back up (for next frame)
-  buf->BeginRecording();
+  // the backend records into a command buffer of its own, so it can be set up as soon as the game presents
+  if (!hasTriedInitImGui && nvnDevice && nvnQueue) {
+    hasTriedInitImGui = true;
+    hasInitImGui = nvnImGui::InitImGui();
+  }
+
+  if (hasInitImGui) {
+    // the game's pools get restored at the end of our commands
+    ImguiNvnBackend::setGamePools(__texturePool, __samplerPool);
+    ImguiNvnBackend::setPresentTarget(texIndex < __windowTextureCount ? __windowTextures[texIndex] : nullptr);
+    nvnImGui::procDraw();
+  }
 
   tempPresentTexFunc(queue, window, texIndex);
 }
@@ -97,45 +195,28 @@ NVNboolean queueInit(nvn::Queue *queue, const nvn::QueueBuilder *builder) {
 }
 
 
-NVNboolean cmdBufInit(nvn::CommandBuffer *buffer, nvn::Device *device) {
-  NVNboolean result = tempBufferInitFuncPtr(buffer, device);
+// to hook another proc, add an entry here with the variable the original gets saved to, and the hook function
+static constexpr ProcHooks::Entry procHookEntries[] = {
+    {"nvnQueueInitialize", ProcHooks::install<tempQueueInitFuncPtr, &queueInit>},
+    {"nvnQueuePresentTexture", ProcHooks::install<tempPresentTexFunc, &presentTexture>},
+    {"nvnDeviceInitialize", ProcHooks::install<tempDeviceInitFuncPtr, &deviceInit>},
+    {"nvnCommandBufferSetSamplerPool", ProcHooks::install<tempCommandSetSamplerPoolFunc, &setSamplerPool>},
+    {"nvnCommandBufferSetTexturePool", ProcHooks::install<tempCommandSetTexturePoolFunc, &setTexturePool>},
+    {"nvnWindowSetCrop", ProcHooks::install<tempSetCropFunc, &setCrop>},
+    {"nvnWindowBuilderSetTextures", ProcHooks::install<tempBuilderSetTexturesFunc, &setWindowTextures>},
+};
 
-  if (!hasInitImGui) {
-    // XENO: wait for the right command buffer
-    if (commandBufferCount++ != IMGUI_XENO_COMMAND_BUFFER_ID) {
-      return result;
-    }
-    nvnCmdBuf = buffer;
-    hasInitImGui = nvnImGui::InitImGui();
-  }
-
-  return result;
-}
+static constexpr ProcHooks::Table procHooks(procHookEntries);
 
 nvn::GenericFuncPtrFunc getProc(nvn::Device *device, const char *procName) {
   nvn::GenericFuncPtrFunc ptr = tempGetProcAddressFuncPtr(nvnDevice, procName);
 
-  if (strcmp(procName, "nvnQueueInitialize") == 0) {
-    tempQueueInitFuncPtr = (nvn::QueueInitializeFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &queueInit;
-  } else if (strcmp(procName, "nvnCommandBufferInitialize") == 0) {
-    tempBufferInitFuncPtr = (nvn::CommandBufferInitializeFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &cmdBufInit;
-  } else if (strcmp(procName, "nvnQueuePresentTexture") == 0) {
-    tempPresentTexFunc = (nvn::QueuePresentTextureFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &presentTexture;
-  } else if (strcmp(procName, "nvnDeviceInitialize") == 0) {
-    tempDeviceInitFuncPtr = (nvn::DeviceInitializeFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &deviceInit;
-  } else if (strcmp(procName, "nvnCommandBufferSetSamplerPool") == 0) {
-    tempCommandSetSamplerPoolFunc = (nvn::CommandBufferSetSamplerPoolFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &setSamplerPool;
-  } else if (strcmp(procName, "nvnCommandBufferSetTexturePool") == 0) {
-    tempCommandSetTexturePoolFunc = (nvn::CommandBufferSetTexturePoolFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &setTexturePool;
-  } else if (strcmp(procName, "nvnWindowSetCrop") == 0) {
-    tempSetCropFunc = (nvn::WindowSetCropFunc) ptr;
-    return (nvn::GenericFuncPtrFunc) &setCrop;
+#if IMGUI_XENO_LOG_PROC_LOOKUPS
+  Logger::log("Getting Proc: %s\n", procName);
+#endif
+
+  if (auto hook = procHooks.find(procName)) {
+    return (nvn::GenericFuncPtrFunc) hook->install((void *) ptr);
   }
 
   return ptr;
@@ -150,18 +231,22 @@ void disableButtons(nn::hid::NpadBaseState *state) {
   }
 }
 
+static constexpr ProcHooks::Entry bootstrapHookEntries[] = {
+    {"nvnDeviceInitialize", ProcHooks::install<tempDeviceInitFuncPtr, &deviceInit>},
+    {"nvnDeviceGetProcAddress", ProcHooks::install<tempGetProcAddressFuncPtr, &getProc>},
+};
+
+static constexpr ProcHooks::Table bootstrapHooks(bootstrapHookEntries);
+
 void* nvnImGui::NvnBootstrapHook(const char *funcName, OrigNvnBootstrap origFn) {
   void *result = origFn(funcName);
 
+#if IMGUI_XENO_LOG_PROC_LOOKUPS
   Logger::log("Getting Proc from Bootstrap: %s\n", funcName);
+#endif
 
-  if (strcmp(funcName, "nvnDeviceInitialize") == 0) {
-    tempDeviceInitFuncPtr = (nvn::DeviceInitializeFunc) result;
-    return (void *) &deviceInit;
-  }
-  if (strcmp(funcName, "nvnDeviceGetProcAddress") == 0) {
-    tempGetProcAddressFuncPtr = (nvn::DeviceGetProcAddressFunc) result;
-    return (void *) &getProc;
+  if (auto hook = bootstrapHooks.find(funcName)) {
+    return hook->install(result);
   }
 
   return result;
@@ -172,6 +257,20 @@ void nvnImGui::addDrawFunc(ProcDrawFunc func) {
   XENO_ASSERT(!drawQueue.contains(func), "Function has already been added to queue!");
 
   drawQueue.push_back(func);
+
+  auto *state = IM_NEW(CallbackState)();
+  state->interval = 1;
+  __callbackStates.push_back(state);
+}
+
+void nvnImGui::addPanelFunc(ProcDrawFunc func) {
+#if IMGUI_XENO_PANEL_THREADS > 0
+  if (PanelWorkers::addPanel(func)) {
+    return;
+  }
+#endif
+
+  addDrawFunc(func);
 }
 
 void nvnImGui::addInitFunc(InitFunc func) {
@@ -180,20 +279,484 @@ void nvnImGui::addInitFunc(InitFunc func) {
   initQueue.push_back(func);
 }
 
-void nvnImGui::procDraw() {
+#if IMGUI_VERSION_NUM >= 18980
+static void clearCachedLists(CallbackState &state) {
+  for (auto list: state.cachedLists) {
+    IM_DELETE(list);
+  }
+  state.cachedLists.resize(0);
+}
+#endif
+
+// adds the windows submitted since the last call to __activeWindows, and their IDs to newWindows if set
+static void collectActiveWindows(ImVector<ImGuiID> *newWindows) {
+  ImGuiContext &g = *GImGui;
+
+  for (auto window: g.Windows) {
+    if (window->LastFrameActive != g.FrameCount || __activeWindows.contains(window)) {
+      continue;
+    }
+
+    __activeWindows.push_back(window);
+    if (newWindows) {
+      newWindows->push_back(window->ID);
+    }
+  }
+}
+
+// demotes callbacks that keep running over budget, and promotes them back once they stay under it
+static void updateCallbackBudget(int idx, CallbackState &state) {
+
+  if (state.lastMs > __callbackBudgetMs) {
+    state.underBudgetCount = 0;
+
+    if (++state.overBudgetCount >= IMGUI_XENO_CALLBACK_STRIKES && state.interval < IMGUI_XENO_CALLBACK_MAX_INTERVAL) {
+      state.overBudgetCount = 0;
+      state.interval = ImMin(state.interval * 2, IMGUI_XENO_CALLBACK_MAX_INTERVAL);
+      Logger::log("Draw Callback %d is over budget (%.3f ms > %.3f ms), now running every %d updates.\n", idx,
+                  state.lastMs, __callbackBudgetMs, state.interval);
+    }
+    return;
+  }
+
+  state.overBudgetCount = 0;
+
+  if (state.interval > 1 && ++state.underBudgetCount >= IMGUI_XENO_CALLBACK_STRIKES) {
+    state.underBudgetCount = 0;
+    state.interval /= 2;
+    Logger::log("Draw Callback %d is back under budget, now running every %d updates.\n", idx, state.interval);
+  }
+}
+
+// runs the draw callbacks due this update, timing each of them
+static void runDrawCallbacks() {
+#if IMGUI_VERSION_NUM < 18980
+  // the windows of a skipped callback are redrawn through ImDrawData::AddDrawList, so callbacks only get timed
+  if (__callbackBudgetMs > 0.0f && !__isBudgetWarned) {
+    Logger::log("Draw Callback Budgets need ImGui 1.89.8 or newer! Callbacks won't be demoted.\n");
+    __isBudgetWarned = true;
+  }
+  bool isBudgetEnabled = false;
+#else
+  bool isBudgetEnabled = __callbackBudgetMs > 0.0f;
+#endif
+
+  if (isBudgetEnabled) {
+    __activeWindows.resize(0);
+    collectActiveWindows(nullptr);
+  }
+
+  for (int i = 0; i < nvnImGui::drawQueue.Size; i++) {
+    CallbackState &state = *__callbackStates[i];
+    state.hasRun = false;
+
+    if (!isBudgetEnabled && state.interval > 1) {
+      state.interval = 1;
+      state.overBudgetCount = state.underBudgetCount = 0;
+    }
+
+    if (state.interval > 1 && ++state.skippedUpdates < state.interval) {
+      continue;
+    }
+    state.skippedUpdates = 0;
+
+    nn::os::Tick callbackTick = nn::os::GetSystemTick();
+
+    nvnImGui::drawQueue[i]();
+
+    state.lastMs = ImguiNvnBackend::getElapsedMs(callbackTick);
+    state.hasRun = true;
+    __buildStats.callbacksMs += state.lastMs;
+
+    if (isBudgetEnabled) {
+      state.windowIds.resize(0);
+      collectActiveWindows(&state.windowIds);
+      updateCallbackBudget(i, state);
+    }
+  }
+
+  __buildStats.callbackCount = ImMin(nvnImGui::drawQueue.Size, IMGUI_XENO_MAX_CALLBACK_STATS);
+  for (int i = 0; i < __buildStats.callbackCount; i++) {
+    __buildStats.callbackMs[i] = __callbackStates[i]->lastMs;
+    __buildStats.callbackInterval[i] = __callbackStates[i]->interval;
+  }
+}
+
+// keeps the windows of demoted callbacks on screen: copies their draw lists when they ran, and adds the copies to the
+// draw data when they were skipped. the copies end up on top of the other windows, and can't be interacted with.
+static void drawSkippedCallbacks() {
+#if IMGUI_VERSION_NUM >= 18980
+  ImDrawData *drawData = ImGui::GetDrawData();
+
+  for (auto state: __callbackStates) {
+    if (state->interval == 1) {
+      if (!state->cachedLists.empty()) {
+        clearCachedLists(*state);
+      }
+      continue;
+    }
+
+    if (!state->hasRun) {
+      for (auto list: state->cachedLists) {
+        drawData->AddDrawList(list);
+      }
+      continue;
+    }
+
+    clearCachedLists(*state);
+    for (auto id: state->windowIds) {
+      ImGuiWindow *window = ImGui::FindWindowByID(id);
+      if (window && ImGui::IsWindowActiveAndVisible(window)) {
+        state->cachedLists.push_back(window->DrawList->CloneOutput());
+      }
+    }
+  }
+#endif
+}
+
+void nvnImGui::buildFrame() {
+  nn::os::Tick startTick = nn::os::GetSystemTick();
+
   ImguiNvnBackend::newFrame();
+#if IMGUI_XENO_PANEL_THREADS > 0
+  // panels get built on the workers while the main context runs its callbacks
+  PanelWorkers::beginPanels();
+#endif
   ImGui::NewFrame();
   ImGui::GetIO().MouseDrawCursor = InputHelper::toggleInput;
   if (ImGui::GetMousePos().x < 1 || ImGui::GetMousePos().y < 1) {
     ImGui::GetIO().MouseDrawCursor = false;
   }
 
-  for (auto drawFunc: drawQueue) {
-    drawFunc();
-  }
+  __buildStats.newFrameMs = ImguiNvnBackend::getElapsedMs(startTick);
+  __buildStats.callbacksMs = 0.0f;
 
+  runDrawCallbacks();
+
+  nn::os::Tick renderTick = nn::os::GetSystemTick();
   ImGui::Render();
+  drawSkippedCallbacks();
+  __buildStats.renderMs = ImguiNvnBackend::getElapsedMs(renderTick);
+
+#if IMGUI_XENO_PANEL_THREADS > 0
+  PanelWorkers::endPanels(ImGui::GetDrawData());
+  PanelWorkers::getStats(&__buildStats);
+#endif
+
+  __lastUpdate = nn::os::GetSystemTick().ToTimeSpan();
+  __isInteracting = ImGui::IsAnyItemActive() || ImGui::GetIO().WantTextInput;
+#if IMGUI_XENO_PANEL_THREADS > 0
+  __isInteracting |= PanelWorkers::isInteracting();
+#endif
+}
+
+static const DrawnFrameStats &getDrawnStats() {
+#if IMGUI_XENO_ASYNC_FRAMES
+  if (__workerStack) {
+    return __publishedStats;
+  }
+#endif
+  return __drawnStats;
+}
+
+void nvnImGui::getFrameStats(ImguiXenoFrameStats *stats) {
+  *stats = getDrawnStats().stats;
+}
+
+void nvnImGui::captureFrame(const char *path) {
+  if (!hasInitImGui) {
+    Logger::log("Cannot Capture a Frame before ImGui is Initialized!\n");
+    return;
+  }
+
+  ImguiNvnBackend::requestCapture(path);
+}
+
+// the texture API can already be used by the init callbacks, before InitImGui returns. panels have no backend
+static bool isTextureApiReady() {
+  if (!ImGui::GetCurrentContext() || !ImGui::GetIO().BackendRendererUserData ||
+      !ImguiNvnBackend::getBackendData()->isInitialized) {
+    Logger::log("Cannot Use Textures before the Backend is Initialized, or from Panels!\n");
+    return false;
+  }
+
+  return true;
+}
+
+ImguiXenoTexture nvnImGui::createTexture(int width, int height, ImguiXenoTextureFormat format, const void *data) {
+  return isTextureApiReady() ? ImguiNvnBackend::createUserTexture(width, height, format, data) : 0;
+}
+
+bool nvnImGui::updateTexture(ImguiXenoTexture texture, int x, int y, int width, int height, const void *data,
+                             int pitch) {
+  return isTextureApiReady() && ImguiNvnBackend::updateUserTexture(texture, x, y, width, height, data, pitch);
+}
+
+void nvnImGui::destroyTexture(ImguiXenoTexture texture) {
+  if (isTextureApiReady()) {
+    ImguiNvnBackend::destroyUserTexture(texture);
+  }
+}
+
+void *nvnImGui::getTextureId(ImguiXenoTexture texture) {
+  return isTextureApiReady() ? (void *) ImguiNvnBackend::getUserTextureHandle(texture) : nullptr;
+}
+
+// fills in the stats of the frame that was just drawn, and adds its timings to the history. builtStats are the timings
+// of the update that built it, null if the last update was drawn again (those count as 0 ms)
+static void pushFrameStats(const ImguiXenoFrameStats *builtStats) {
+  auto bd = ImguiNvnBackend::getBackendData();
+  DrawnFrameStats &drawn = __drawnStats;
+
+  if (builtStats) {
+    drawn.stats = *builtStats;
+  }
+  drawn.stats.recordMs = bd->recordMs;
+  drawn.stats.gpuMs = bd->gpuMs;
+  drawn.stats.cmdCount = bd->drawStats.cmdsIn;
+  drawn.stats.drawCount = bd->drawStats.drawsOut;
+  drawn.stats.vtxCount = bd->drawStats.vtxCount;
+  drawn.stats.idxCount = bd->drawStats.idxCount;
+  drawn.stats.skippedBindCount = bd->drawStats.skippedBinds;
+  drawn.stats.replayed = bd->drawStats.isReplayed;
+
+  drawn.updateHistory[drawn.historyOffset] = builtStats ? builtStats->newFrameMs + builtStats->callbacksMs +
+                                                          builtStats->renderMs : 0.0f;
+  drawn.recordHistory[drawn.historyOffset] = bd->recordMs;
+  drawn.gpuHistory[drawn.historyOffset] = bd->gpuMs;
+  drawn.historyOffset = (drawn.historyOffset + 1) % StatsHistorySize;
+}
+
+static void plotHistory(const char *label, const float *history, int historyOffset) {
+  float maxMs = 0.0f, sumMs = 0.0f;
+  for (int i = 0; i < StatsHistorySize; i++) {
+    maxMs = history[i] > maxMs ? history[i] : maxMs;
+    sumMs += history[i];
+  }
+
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "avg %.3f ms, max %.3f ms", sumMs / StatsHistorySize, maxMs);
+  ImGui::PlotLines(label, history, StatsHistorySize, historyOffset, overlay, 0.0f, maxMs > 1.0f ? maxMs : 1.0f,
+                   ImVec2(0, 60));
+}
+
+void nvnImGui::drawStatsWindow() {
+  const DrawnFrameStats &drawn = getDrawnStats();
+  const ImguiXenoFrameStats &stats = drawn.stats;
+
+  if (!ImGui::Begin("imgui-xeno Stats")) {
+    ImGui::End();
+    return;
+  }
+
+  plotHistory("UI Update", drawn.updateHistory, drawn.historyOffset);
+  plotHistory("Recording", drawn.recordHistory, drawn.historyOffset);
+  plotHistory("GPU", drawn.gpuHistory, drawn.historyOffset);
+
+  ImGui::Text("NewFrame: %.3f ms, Callbacks: %.3f ms, Render: %.3f ms", stats.newFrameMs, stats.callbacksMs,
+              stats.renderMs);
+  for (int i = 0; i < stats.callbackCount; i++) {
+    if (stats.callbackInterval[i] > 1) {
+      ImGui::Text("  Callback %d: %.3f ms (every %d updates)", i, stats.callbackMs[i], stats.callbackInterval[i]);
+    } else {
+      ImGui::Text("  Callback %d: %.3f ms", i, stats.callbackMs[i]);
+    }
+  }
+  for (int i = 0; i < stats.panelCount; i++) {
+    ImGui::Text("  Panel %d: %.3f ms", i, stats.panelMs[i]);
+  }
+  if (stats.panelCount > 0) {
+    ImGui::Text("Waited for Panels: %.3f ms", stats.panelWaitMs);
+  }
+  if (stats.replayed) {
+    ImGui::Text("Replayed the last Recording");
+  } else {
+    ImGui::Text("Commands: %d, Draws: %d, Skipped Binds: %d", stats.cmdCount, stats.drawCount,
+                stats.skippedBindCount);
+  }
+  ImGui::Text("Vertices: %d, Indices: %d", stats.vtxCount, stats.idxCount);
+
+  ImGui::End();
+}
+
+void nvnImGui::setUpdateRate(float rate) {
+  __updateRate = rate;
+}
+
+void nvnImGui::requestUpdate() {
+  __isUpdateRequested = true;
+}
+
+void nvnImGui::setCallbackBudget(float budgetMs) {
+  __callbackBudgetMs = budgetMs;
+}
+
+// decides whether a new ImGui frame gets built, or the last one is drawn again. input is still polled on skipped
+// frames, so interacting with the overlay switches it back to full rate right away.
+// must only be called while no other thread uses the ImGui context
+static bool shouldBuildFrame() {
+
+  if (__updateRate == 0.0f) {
+    return true;
+  }
+
+  nn::TimeSpanType now = nn::os::GetSystemTick().ToTimeSpan();
+
+  ImguiNvnBackend::pollInput();
+  if (__isInteracting || InputHelper::isInputActive()) {
+    __lastInteraction = now;
+  }
+
+  if ((now - __lastInteraction).GetNanoSeconds() < IMGUI_XENO_INTERACTION_HOLD_MS * 1000000LL) {
+    return true;
+  }
+
+  if (__isUpdateRequested) {
+    __isUpdateRequested = false;
+    return true;
+  }
+
+  return __updateRate > 0.0f && (now - __lastUpdate).GetNanoSeconds() >= (s64) (1e9f / __updateRate);
+}
+
+#if IMGUI_XENO_ASYNC_FRAMES
+template <typename T>
+static void copyVector(ImVector<T> &dst, const ImVector<T> &src) {
+  dst.resize(src.Size);
+  memcpy(dst.Data, src.Data, src.size_in_bytes());
+}
+
+static void copyDrawData(DrawDataSnapshot &snapshot, ImDrawData *drawData) {
+
+  while (snapshot.lists.Size < drawData->CmdListsCount) {
+    snapshot.lists.push_back(IM_NEW(ImDrawList)(nullptr));
+  }
+
+  for (int i = 0; i < drawData->CmdListsCount; i++) {
+    auto src = drawData->CmdLists[i];
+    auto dst = snapshot.lists[i];
+
+    copyVector(dst->CmdBuffer, src->CmdBuffer);
+    copyVector(dst->IdxBuffer, src->IdxBuffer);
+    copyVector(dst->VtxBuffer, src->VtxBuffer);
+  }
+
+  ImDrawData &dst = snapshot.drawData;
+  dst.Valid = drawData->Valid;
+  dst.CmdListsCount = drawData->CmdListsCount;
+  dst.TotalIdxCount = drawData->TotalIdxCount;
+  dst.TotalVtxCount = drawData->TotalVtxCount;
+  dst.DisplayPos = drawData->DisplayPos;
+  dst.DisplaySize = drawData->DisplaySize;
+  dst.FramebufferScale = drawData->FramebufferScale;
+
+#if IMGUI_VERSION_NUM >= 18980
+  // CmdLists became an owned ImVector in 1.89.8
+  dst.CmdLists.resize(drawData->CmdListsCount);
+  for (int i = 0; i < drawData->CmdListsCount; i++) {
+    dst.CmdLists[i] = snapshot.lists[i];
+  }
+#else
+  dst.CmdLists = snapshot.lists.Data;
+#endif
+}
+
+static void asyncWorkerMain(void *) {
+  while (true) {
+    nn::os::WaitEvent(&__kickEvent);
+
+    nvnImGui::buildFrame();
+    copyDrawData(__snapshots[1 - __readIdx], ImGui::GetDrawData());
+    __snapshots[1 - __readIdx].stats = __buildStats;
+
+    nn::os::SignalEvent(&__readyEvent);
+  }
+}
+
+static bool startAsyncWorker() {
+
+  __workerStack = Mem::AllocateAlign(0x1000, IMGUI_XENO_ASYNC_STACK_SIZE);
+  if (!__workerStack) {
+    Logger::log("Failed to Allocate ImGui Worker Stack!\n");
+    return false;
+  }
+
+  nn::os::InitializeEvent(&__kickEvent, false, true);
+  nn::os::InitializeEvent(&__readyEvent, false, true);
+
+  if (R_FAILED(nn::os::CreateThread(&__workerThread, asyncWorkerMain, nullptr, __workerStack,
+                                    IMGUI_XENO_ASYNC_STACK_SIZE, IMGUI_XENO_ASYNC_THREAD_PRIORITY))) {
+    Logger::log("Failed to Create ImGui Worker Thread!\n");
+    nn::os::FinalizeEvent(&__kickEvent);
+    nn::os::FinalizeEvent(&__readyEvent);
+    Mem::Deallocate(__workerStack);
+    return false;
+  }
+
+  nn::os::SetThreadName(&__workerThread, "ImGuiWorker");
+  nn::os::StartThread(&__workerThread);
+
+  Logger::log("Started ImGui Worker Thread.\n");
+
+  return true;
+}
+
+// draws the latest frame finished by the worker, then starts it on the next one. the render thread never waits for
+// the worker: if it isn't done yet, the previous frame is simply drawn again.
+// the worker hands over draw data rather than recorded commands, recording the snapshot stays on the render thread:
+// the overlay cache composites onto the texture being presented, and the pools given back to the game at the end are
+// the ones captured along with it. recording also waits on the fences of the frame ring, which only get written on
+// the game's queue here, same as the replays of unchanged frames that reuse the ring slot of the last recording
+static void drawAsyncFrame() {
+
+  const ImguiXenoFrameStats *builtStats = nullptr;
+  if (__isWorkerBusy && nn::os::TryWaitEvent(&__readyEvent)) {
+    __readIdx = 1 - __readIdx;
+    __isWorkerBusy = false;
+    __hasFrame = true;
+    builtStats = &__snapshots[__readIdx].stats;
+
+#if IMGUI_XENO_DYNAMIC_FONT_ATLAS
+    // snapshots don't copy the textures, so they get updated from ImGui's draw data before the frame is drawn. the
+    // worker is parked until the next kick, so it can't change them meanwhile
+    ImguiNvnBackend::updateTextures(ImGui::GetDrawData());
+#endif
+  }
+
+  if (__hasFrame) {
+    ImguiNvnBackend::renderDrawData(&__snapshots[__readIdx].drawData);
+  }
+  pushFrameStats(builtStats);
+
+  // the worker is idle here, so the throttle can safely poll input into the ImGui context
+  if (!__isWorkerBusy && (!__hasFrame || shouldBuildFrame())) {
+    applyWindowCrop();
+    __publishedStats = __drawnStats;
+    __isWorkerBusy = true;
+    nn::os::SignalEvent(&__kickEvent);
+  }
+}
+#endif
+
+void nvnImGui::procDraw() {
+#if IMGUI_XENO_ASYNC_FRAMES
+  if (__workerStack) {
+    drawAsyncFrame();
+    return;
+  }
+#endif
+
+  // skipped updates keep drawing the draw data of the last built frame, which stays valid until the next NewFrame
+  static bool hasBuiltFrame = false;
+  bool isBuilt = !hasBuiltFrame || shouldBuildFrame();
+  if (isBuilt) {
+    applyWindowCrop();
+    buildFrame();
+    hasBuiltFrame = true;
+  }
+
   ImguiNvnBackend::renderDrawData(ImGui::GetDrawData());
+  pushFrameStats(isBuilt ? &__buildStats : nullptr);
 }
 
 void nvnImGui::InstallHooks() {
@@ -207,7 +770,7 @@ void nvnImGui::InstallHooks() {
 }
 
 bool nvnImGui::InitImGui() {
-  if (nvnDevice && nvnQueue && nvnCmdBuf) {
+  if (nvnDevice && nvnQueue) {
 
     Logger::log("Creating ImGui with Ver.\n");
 
@@ -235,8 +798,7 @@ bool nvnImGui::InitImGui() {
 
     ImguiNvnBackend::NvnBackendInitInfo initInfo = {
         .device = nvnDevice,
-        .queue = nvnQueue,
-        .cmdBuf = nvnCmdBuf
+        .queue = nvnQueue
     };
 
     Logger::log("Initializing Backend.\n");
@@ -252,10 +814,33 @@ bool nvnImGui::InitImGui() {
       init();
     }
 
+#if !IMGUI_XENO_DYNAMIC_FONT_ATLAS
+    // baked after the init callbacks, so the fonts they add are part of the atlas (and of its cache)
+    auto bd = ImguiNvnBackend::getBackendData();
+    if (bd->isInitialized && !ImguiNvnBackend::setupFontTexture()) {
+      Logger::log("Failed to Setup Font Texture!\n");
+      bd->isInitialized = false;
+    }
+#endif
+
 #if IMGUI_XENO_DRAW_DEMO
     addDrawFunc([]() { ImGui::ShowDemoWindow(); });
 #endif
 
+#if IMGUI_XENO_DRAW_STATS
+    addDrawFunc(drawStatsWindow);
+#endif
+
+#if IMGUI_XENO_PANEL_THREADS > 0
+    // falls back to building panels one after the other if no worker can be started
+    PanelWorkers::start();
+#endif
+
+#if IMGUI_XENO_ASYNC_FRAMES
+    // falls back to building frames on the render thread if the worker can't be started
+    startAsyncWorker();
+#endif
+
     return true;
 
   } else {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.h"
+#include "xeno_types.h"
 
 #define IMGUINVN_ADDDRAW(FuncBody) nvnImGui::addDrawFunc([]() {             \
 FuncBody                                                                    \
@@ -16,9 +17,36 @@ namespace nvnImGui {
 
   bool InitImGui();
 
+  // runs NewFrame, every draw callback and Render
+  void buildFrame();
+
   void procDraw();
 
+  void setUpdateRate(float rate);
+
+  void requestUpdate();
+
+  void setCallbackBudget(float budgetMs);
+
+  void getFrameStats(ImguiXenoFrameStats *stats);
+
+  void captureFrame(const char *path);
+
+  // user textures, see imgui_xeno_create_texture
+  ImguiXenoTexture createTexture(int width, int height, ImguiXenoTextureFormat format, const void *data);
+
+  bool updateTexture(ImguiXenoTexture texture, int x, int y, int width, int height, const void *data, int pitch);
+
+  void destroyTexture(ImguiXenoTexture texture);
+
+  void *getTextureId(ImguiXenoTexture texture);
+
+  // built-in window plotting the last few seconds of overlay timings
+  void drawStatsWindow();
+
   void addDrawFunc(ProcDrawFunc func);
+  // panels are draw callbacks built on a worker thread in an ImGui context of their own (see IMGUI_XENO_PANEL_THREADS)
+  void addPanelFunc(ProcDrawFunc func);
   void addInitFunc(InitFunc func);
   void* NvnBootstrapHook(const char *funcName, OrigNvnBootstrap origFn);
 }
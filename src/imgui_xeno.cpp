@@ -8,10 +8,52 @@ extern "C" void imgui_xeno_init(InitFunc init, ProcDrawFunc renderCallback) {
   nvnImGui::addDrawFunc(renderCallback);
 }
 
+extern "C" void imgui_xeno_add_panel(ProcDrawFunc renderCallback) {
+  nvnImGui::addPanelFunc(renderCallback);
+}
+
 extern "C" void* imgui_xeno_bootstrap_hook(const char *functionName, nvnImGui::OrigNvnBootstrap origFn) {
   return nvnImGui::NvnBootstrapHook(functionName, origFn);
 }
 
 extern "C" void imgui_xeno_set_logger(LoggerFunc loggerCallback) {
   Logger::instance().forward(loggerCallback);
+}
+
+extern "C" void imgui_xeno_set_update_rate(float rate) {
+  nvnImGui::setUpdateRate(rate);
+}
+
+extern "C" void imgui_xeno_request_update() {
+  nvnImGui::requestUpdate();
+}
+
+extern "C" void imgui_xeno_set_callback_budget(float budgetMs) {
+  nvnImGui::setCallbackBudget(budgetMs);
+}
+
+extern "C" void imgui_xeno_get_frame_stats(ImguiXenoFrameStats *stats) {
+  nvnImGui::getFrameStats(stats);
+}
+
+extern "C" void imgui_xeno_capture_frame(const char *path) {
+  nvnImGui::captureFrame(path);
+}
+
+extern "C" ImguiXenoTexture imgui_xeno_create_texture(int width, int height, ImguiXenoTextureFormat format,
+                                                      const void *data) {
+  return nvnImGui::createTexture(width, height, format, data);
+}
+
+extern "C" bool imgui_xeno_update_texture(ImguiXenoTexture texture, int x, int y, int width, int height,
+                                          const void *data, int pitch) {
+  return nvnImGui::updateTexture(texture, x, y, width, height, data, pitch);
+}
+
+extern "C" void imgui_xeno_destroy_texture(ImguiXenoTexture texture) {
+  nvnImGui::destroyTexture(texture);
+}
+
+extern "C" void *imgui_xeno_get_texture_id(ImguiXenoTexture texture) {
+  return nvnImGui::getTextureId(texture);
 }
\ No newline at end of file
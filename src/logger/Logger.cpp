@@ -2,6 +2,7 @@
 #include "imgui_backend_config.h"
 #include "nifm.h"
 #include "util.h"
+#include <cstdio>
 #include <cstring>
 
 #if IMGUI_XENO_LOG_TCP
@@ -14,7 +15,11 @@ Logger &Logger::instance() {
 }
 
 NOINLINE void outputDebugString(const char *buf, size_t len) {
+#ifdef IMGUI_XENO_HOST
+  fwrite(buf, 1, len, stderr);
+#else
   asm("svc 0x27");
+#endif
 }
 
 void Logger::log(const char *fmt, ...) {
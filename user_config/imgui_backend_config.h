@@ -8,15 +8,70 @@
 
 // Graphics
 
-// ID starts at 0.
-// The first command buffer that is initialized in Xenoblade games is too small for ImGui
-#define IMGUI_XENO_COMMAND_BUFFER_ID 1
 // Might be necessary if the game doesn't expose glslc
 #define IMGUI_XENO_FORCE_PRECOMPILED_SHADERS false
 // Base path for shaders. Note: file system must be mounted before the call to imgui_xeno_init
 #define IMGUI_XENO_SHADER_PATH "rom:/imgui/shaders"
 #define IMGUI_XENO_VIEWPORT_WIDTH 1280
 #define IMGUI_XENO_VIEWPORT_HEIGHT 720
+// Upload the font atlas as a single channel R8 texture instead of RGBA8, using a quarter of the memory (large CJK
+// atlases take several MB otherwise). Only the glyph coverage is kept, so leave it disabled if the atlas has colored
+// glyphs (e.g. color emoji) or colored custom rects.
+#define IMGUI_XENO_ALPHA8_FONT false
+// Needs ImGui 1.92 or newer. Glyphs are rasterized into a fixed size atlas as text uses them, instead of baking every
+// glyph range at init, and only the rectangles that changed get uploaded. Once the atlas is full, ImGui discards the
+// font sizes that haven't been used recently and repacks the rest into a new texture.
+// Not compatible with IMGUI_XENO_PANEL_THREADS.
+#define IMGUI_XENO_DYNAMIC_FONT_ATLAS false
+#define IMGUI_XENO_FONT_ATLAS_SIZE 1024
+// Save the baked font atlas (glyph tables and texture) to the SD card, and load it from there on later boots instead of
+// rasterizing the fonts again. The cache is rebuilt whenever the fonts, their sizes/glyph ranges or ImGui change.
+// Needs ImGui 1.87 to 1.91, and the file system must be mounted before the call to imgui_xeno_init.
+#define IMGUI_XENO_FONT_CACHE false
+#define IMGUI_XENO_FONT_CACHE_PATH "sd:/imgui_xeno"
+// Number of textures that can be registered with imgui_xeno_create_texture at once. They share the backend's texture
+// descriptors with the textures ImGui creates itself, so at most 93.
+#define IMGUI_XENO_MAX_USER_TEXTURES 64
+// Size of the ring texture updates are streamed through (see imgui_xeno_update_texture), the GPU copies them into
+// their texture before the frame that follows them draws. User texture updates that don't fit fail, and the render
+// thread waits on the GPU before writing ImGui's own texture updates that don't fit directly.
+#define IMGUI_XENO_STAGING_SIZE 0x100000
+// Number of frames the GPU may have in flight. Each frame gets its own vertex/index memory, fenced with a nvn::Sync,
+// so the CPU never writes into geometry the GPU is still reading.
+#define IMGUI_XENO_FRAMES_IN_FLIGHT 3
+// Size of each memory pool the backend sub-allocates its GPU memory from (must be a power of two).
+// Allocations bigger than half a chunk get a pool of their own.
+#define IMGUI_XENO_ARENA_CHUNK_SIZE 0x40000
+// Upload vertex/index data with non-temporal stores (stnp) instead of memcpy. Experimental: whether it is any faster
+// than memcpy on the console hasn't been measured. `imgui_xeno_bench --copy` compares both copies on an AArch64 host.
+#define IMGUI_XENO_NON_TEMPORAL_UPLOAD false
+// Write draw arguments into an indirect buffer and submit them with one MultiDrawElementsIndirectCount per run of
+// batches sharing a texture, instead of recording a draw for every batch. Batches whose vertices all lie inside of
+// their scissor share a run across scissors, the others only with batches of the same scissor. Finding them walks the
+// indices of every draw command on the CPU, which can cost more than the draws it saves: not measured on hardware yet.
+// On the host benchmark (mock driver), recording took 2.5-3x as long with it: 1.05 -> 2.5-3.4 ms for the built-in
+// text scene (480k vertices), 75 -> 190-230 us for a capture of 40 windows, whose NVN commands went from 464 to 384.
+#define IMGUI_XENO_INDIRECT_DRAWS false
+// Hash the draw data every frame, and resubmit the previously recorded command stream if nothing changed.
+// With IMGUI_XENO_OVERLAY_CACHE, frames are only resubmitted while the game keeps presenting the same texture, as the
+// recording composites onto it. An unchanged frame then costs a single quad anyway.
+#define IMGUI_XENO_REPLAY_UNCHANGED_FRAMES false
+// Render the overlay into an offscreen texture, only redrawing the areas of windows that changed, and composite it
+// onto the presented texture with a single quad. Needs the game's window textures, captured when the window is built.
+#define IMGUI_XENO_OVERLAY_CACHE false
+// Build ImGui frames (NewFrame, draw callbacks and Render) on a worker thread, one frame ahead of the one being
+// presented. Draw callbacks then run on that thread, so they must be safe to run alongside the game's render thread.
+// Recording and submitting the finished frame still happens on the render thread, when the game presents.
+#define IMGUI_XENO_ASYNC_FRAMES false
+#define IMGUI_XENO_ASYNC_STACK_SIZE 0x20000
+#define IMGUI_XENO_ASYNC_THREAD_PRIORITY 16
+// Number of worker threads building panels (see imgui_xeno_add_panel), 0 runs panels as regular draw callbacks.
+// Each panel gets an ImGui context of its own, so they must not share windows or state with other callbacks.
+// Workers are spread over the cores of IMGUI_XENO_PANEL_CORE_MASK.
+#define IMGUI_XENO_PANEL_THREADS 0
+#define IMGUI_XENO_PANEL_STACK_SIZE 0x20000
+#define IMGUI_XENO_PANEL_THREAD_PRIORITY 16
+#define IMGUI_XENO_PANEL_CORE_MASK 0x7
 
 // Input
 
@@ -30,13 +85,38 @@
 
 // ImGui
 
+// How many times per second the UI is updated (NewFrame, draw callbacks and Render). In between, the last frame keeps
+// being drawn. 0 updates every frame, a negative rate only updates on input or imgui_xeno_request_update.
+// Can be changed at runtime with imgui_xeno_set_update_rate.
+#define IMGUI_XENO_UPDATE_RATE 0
+// After any input, or while a widget is active, the UI updates every frame for this long
+#define IMGUI_XENO_INTERACTION_HOLD_MS 500
+// Time budget of each draw callback in milliseconds, 0 disables it. A callback that runs over budget for
+// IMGUI_XENO_CALLBACK_STRIKES updates in a row is demoted to every other update (then every 4th, up to
+// IMGUI_XENO_CALLBACK_MAX_INTERVAL), and promoted back once it stays under budget as long.
+// Can be changed at runtime with imgui_xeno_set_callback_budget. Demotion needs ImGui 1.89.8 or newer to redraw the
+// windows of skipped callbacks, older versions only time the callbacks (and log it once).
+#define IMGUI_XENO_CALLBACK_BUDGET_MS 0
+#define IMGUI_XENO_CALLBACK_STRIKES 10
+#define IMGUI_XENO_CALLBACK_MAX_INTERVAL 8
 // Change to true to draw the ImGui demo window
 #define IMGUI_XENO_DRAW_DEMO false
+// Change to true to draw a window with the overlay's CPU/GPU timings (see imgui_xeno_get_frame_stats)
+#define IMGUI_XENO_DRAW_STATS false
 // If true, loads Jetbrains Mono as the default font.
 // You can load custom fonts during init using ImGui::GetIO().Fonts->AddFontFromMemoryCompressedTTF
 #define IMGUI_XENO_LOAD_DEFAULT_FONT true
 
+// Debugging
+
+// Directory frame captures are written to (see imgui_xeno_capture_frame), they can be replayed with the host benchmark
+#define IMGUI_XENO_CAPTURE_PATH "sd:/imgui_xeno"
+// Capture the next frame when pressing Minus while holding ZL + ZR
+#define IMGUI_XENO_CAPTURE_HOTKEY false
+
 // Logging
 
 // Logs messages using system calls. If a logger is provided with imgui_xeno_set_logger, it will be used instead.
-#define IMGUI_XENO_LOG_SVC true
\ No newline at end of file
+#define IMGUI_XENO_LOG_SVC true
+// Logs every NVN proc the game looks up. Games can resolve thousands of procs during boot, so this slows it down.
+#define IMGUI_XENO_LOG_PROC_LOOKUPS false
\ No newline at end of file
@@ -1,5 +1,17 @@
 #pragma once
 
 #include "helpers/assert.hpp"
+#include "imgui_backend_config.h"
 
-#define IM_ASSERT(_EXPR) XENO_ASSERT(_EXPR)
\ No newline at end of file
+#define IM_ASSERT(_EXPR) XENO_ASSERT(_EXPR)
+
+// Uncomment to use 32-bit indices, lifting the 64k vertices per draw list limit (e.g. for huge plots).
+// The NVN backend picks the matching index type automatically.
+// #define ImDrawIdx unsigned int
+
+#if IMGUI_XENO_PANEL_THREADS > 0
+// panel workers each build in an ImGui context of their own, so the current context has to be tracked per thread
+struct ImGuiContext;
+ImGuiContext *&xenoCurrentContext();
+#define GImGui xenoCurrentContext()
+#endif